@@ -0,0 +1,365 @@
+/**
+ * @file binary_mask.cpp
+ * @author sunfu-chou (sunfu-chou@gmail.com)
+ * @brief This file contains the implementation of the BinaryMask class and of the popcount kernels.
+ * @version 0.1
+ * @date 2024-01-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "binary_mask.h"
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <stdexcept>
+#include <string>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "bmp.h"
+
+namespace
+{
+/**
+ * @brief Counts the set bits of a word with the parallel (SWAR) bit count: pairs, nibbles, then bytes summed
+ * by one multiplication.
+ */
+inline size_t popcount(uint64_t word)
+{
+    word = word - ((word >> 1) & 0x5555555555555555ULL);
+    word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<size_t>((word * 0x0101010101010101ULL) >> 56);
+}
+
+/**
+ * @brief Returns the table that reverses the bit order of a byte.
+ * BMP files store the leftmost pixel in the most significant bit, the packed rows in the least significant one.
+ */
+const std::array<uint8_t, 256>& reversedBits()
+{
+    static const std::array<uint8_t, 256> table = []() {
+        std::array<uint8_t, 256> reversed{};
+        for (int value = 0; value < 256; ++value)
+        {
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                reversed[value] |= ((value >> bit) & 1) << (7 - bit);
+            }
+        }
+        return reversed;
+    }();
+    return table;
+}
+
+void checkSameSize(const BinaryMask& a, const BinaryMask& b)
+{
+    if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight())
+    {
+        throw std::invalid_argument("Mask sizes do not match");
+    }
+}
+}  // namespace
+
+BinaryMask::BinaryMask(int width, int height, bool value)
+    : width(width), height(height), words_per_row((static_cast<size_t>(width) + 63) / 64)
+{
+    if (width <= 0 || height <= 0)
+    {
+        throw std::invalid_argument("Mask size must be positive");
+    }
+    data.assign(words_per_row * height, value ? ~uint64_t{ 0 } : 0);
+    clearPadding();
+}
+
+BinaryMask::BinaryMask(const Mask& mask) : BinaryMask(mask.getWidth(), mask.getHeight())
+{
+    for (int y = 0; y < height; ++y)
+    {
+        packRow(y, mask.row(y));
+    }
+}
+
+BinaryMask::BinaryMask(const std::filesystem::path& filename, uint8_t level) : width(0), height(0), words_per_row(0)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        throw std::filesystem::filesystem_error("Unable to open file", filename, std::make_error_code(std::io_errc::stream));
+    }
+    BMPFileHeader header;
+    BMPInfoHeader info_header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    file.read(reinterpret_cast<char*>(&info_header), sizeof(info_header));
+    if (!file || header.type != 0x4D42)
+    {
+        throw std::ios_base::failure("Not a BMP file: " + filename.string());
+    }
+
+    if (info_header.bit_count == 1)
+    {
+        readPacked(file, header, info_header);
+    }
+    else
+    {
+        file.close();
+        Mask mask(filename);
+        mask.threshold(level);
+        *this = BinaryMask(mask);
+    }
+}
+
+void BinaryMask::readPacked(std::istream& file, const BMPFileHeader& header, const BMPInfoHeader& info_header)
+{
+    if (info_header.compression != 0)
+    {
+        throw std::ios_base::failure("Unsupported compression: " + std::to_string(info_header.compression));
+    }
+
+    // The palette follows the info header, whose size may differ between BMP versions
+    std::array<uint8_t, 8> palette{};
+    file.seekg(sizeof(BMPFileHeader) + info_header.size, file.beg);
+    file.read(reinterpret_cast<char*>(palette.data()), palette.size());
+    int brightness0 = palette[0] + palette[1] + palette[2];
+    int brightness1 = palette[4] + palette[5] + palette[6];
+    bool inverted = brightness0 > brightness1;
+
+    // A negative height marks a top-down file
+    bool top_down = info_header.height < 0;
+    *this = BinaryMask(info_header.width, top_down ? -info_header.height : info_header.height);
+
+    const auto& reversed = reversedBits();
+    size_t row_size = (static_cast<size_t>(width) + 31) / 32 * 4;
+    std::vector<uint8_t> bytes(words_per_row * 8, 0);
+    file.seekg(header.offset, file.beg);
+    for (int i = 0; i < height; ++i)
+    {
+        file.read(reinterpret_cast<char*>(bytes.data()), row_size);
+        if (!file)
+        {
+            throw std::ios_base::failure("Unexpected end of file");
+        }
+        uint64_t* out = row(top_down ? height - 1 - i : i);
+        for (size_t w = 0; w < words_per_row; ++w)
+        {
+            uint64_t word = 0;
+            for (int b = 0; b < 8; ++b)
+            {
+                word |= static_cast<uint64_t>(reversed[bytes[w * 8 + b]]) << (8 * b);
+            }
+            out[w] = inverted ? ~word : word;
+        }
+    }
+    clearPadding();
+}
+
+void BinaryMask::write(const std::filesystem::path& filename) const
+{
+    std::ofstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        throw std::filesystem::filesystem_error("Unable to open file", filename, std::make_error_code(std::io_errc::stream));
+    }
+
+    size_t row_size = (static_cast<size_t>(width) + 31) / 32 * 4;
+    const std::array<uint8_t, 8> palette{ 0, 0, 0, 0, 255, 255, 255, 0 };
+
+    BMPInfoHeader info_header{};
+    info_header.size = sizeof(BMPInfoHeader);
+    info_header.width = width;
+    info_header.height = height;
+    info_header.planes = 1;
+    info_header.bit_count = 1;
+    info_header.image_size = static_cast<uint32_t>(row_size * height);
+    info_header.used_colors = 2;
+
+    BMPFileHeader header{};
+    header.type = 0x4D42;
+    header.offset = sizeof(BMPFileHeader) + sizeof(BMPInfoHeader) + palette.size();
+    header.size = header.offset + info_header.image_size;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(&info_header), sizeof(info_header));
+    file.write(reinterpret_cast<const char*>(palette.data()), palette.size());
+
+    const auto& reversed = reversedBits();
+    std::vector<uint8_t> bytes(std::max(row_size, words_per_row * 8), 0);
+    for (int y = 0; y < height; ++y)
+    {
+        const uint64_t* in = row(y);
+        for (size_t w = 0; w < words_per_row; ++w)
+        {
+            for (int b = 0; b < 8; ++b)
+            {
+                bytes[w * 8 + b] = reversed[(in[w] >> (8 * b)) & 0xFF];
+            }
+        }
+        // The padding bits are 0, so the bytes past the row are 0 as well
+        file.write(reinterpret_cast<const char*>(bytes.data()), row_size);
+    }
+}
+
+Mask BinaryMask::toMask() const
+{
+    Mask mask(width, height);
+    for (int y = 0; y < height; ++y)
+    {
+        const uint64_t* in = row(y);
+        uint8_t* out = mask.row(y);
+        for (int x = 0; x < width; ++x)
+        {
+            out[x] = ((in[x / 64] >> (x % 64)) & 1) ? 255 : 0;
+        }
+    }
+    return mask;
+}
+
+void BinaryMask::packRow(int y, const uint8_t* pixels, uint8_t level)
+{
+    uint64_t* out = row(y);
+    std::fill_n(out, words_per_row, 0);
+    if (level == 255)
+    {
+        return;
+    }
+    int x = 0;
+#ifdef __SSE2__
+    // Sixteen pixels at a time: a pixel is above the level when max(pixel, level + 1) is the pixel itself
+    const __m128i bound = _mm_set1_epi8(static_cast<char>(level + 1));
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + x));
+        uint64_t bits = static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(bytes, bound), bytes)));
+        out[x / 64] |= bits << (x % 64);
+    }
+#endif
+    for (; x < width; ++x)
+    {
+        out[x / 64] |= static_cast<uint64_t>(pixels[x] > level) << (x % 64);
+    }
+}
+
+int BinaryMask::getWidth() const
+{
+    return width;
+}
+
+int BinaryMask::getHeight() const
+{
+    return height;
+}
+
+size_t BinaryMask::getWordsPerRow() const
+{
+    return words_per_row;
+}
+
+uint64_t* BinaryMask::row(int y)
+{
+    return &data[static_cast<size_t>(y) * words_per_row];
+}
+
+const uint64_t* BinaryMask::row(int y) const
+{
+    return &data[static_cast<size_t>(y) * words_per_row];
+}
+
+bool BinaryMask::get(int x, int y) const
+{
+    return (row(y)[x / 64] >> (x % 64)) & 1;
+}
+
+void BinaryMask::set(int x, int y, bool value)
+{
+    uint64_t bit = uint64_t{ 1 } << (x % 64);
+    uint64_t& word = row(y)[x / 64];
+    word = value ? (word | bit) : (word & ~bit);
+}
+
+size_t BinaryMask::count() const
+{
+    size_t total = 0;
+    for (uint64_t word : data)
+    {
+        total += popcount(word);
+    }
+    return total;
+}
+
+void BinaryMask::invert()
+{
+    for (uint64_t& word : data)
+    {
+        word = ~word;
+    }
+    clearPadding();
+}
+
+void BinaryMask::clearPadding()
+{
+    if (width % 64 == 0)
+    {
+        return;
+    }
+    uint64_t keep = (uint64_t{ 1 } << (width % 64)) - 1;
+    for (int y = 0; y < height; ++y)
+    {
+        row(y)[words_per_row - 1] &= keep;
+    }
+}
+
+BinaryMask& BinaryMask::operator&=(const BinaryMask& other)
+{
+    checkSameSize(*this, other);
+    std::transform(data.begin(), data.end(), other.data.begin(), data.begin(), [](uint64_t a, uint64_t b) { return a & b; });
+    return *this;
+}
+
+BinaryMask& BinaryMask::operator|=(const BinaryMask& other)
+{
+    checkSameSize(*this, other);
+    std::transform(data.begin(), data.end(), other.data.begin(), data.begin(), [](uint64_t a, uint64_t b) { return a | b; });
+    return *this;
+}
+
+BinaryMask& BinaryMask::operator^=(const BinaryMask& other)
+{
+    checkSameSize(*this, other);
+    std::transform(data.begin(), data.end(), other.data.begin(), data.begin(), [](uint64_t a, uint64_t b) { return a ^ b; });
+    return *this;
+}
+
+Overlap overlap(const BinaryMask& a, const BinaryMask& b)
+{
+    checkSameSize(a, b);
+    Overlap result{ 0, 0, 0, 0 };
+    size_t words = a.getWordsPerRow() * a.getHeight();
+    // The rows are contiguous, so both masks are walked as one array of words
+    const uint64_t* wa = a.row(0);
+    const uint64_t* wb = b.row(0);
+    for (size_t i = 0; i < words; ++i)
+    {
+        result.intersection += popcount(wa[i] & wb[i]);
+        result.first += popcount(wa[i]);
+        result.second += popcount(wb[i]);
+    }
+    result.union_count = result.first + result.second - result.intersection;
+    return result;
+}
+
+double iou(const BinaryMask& a, const BinaryMask& b)
+{
+    Overlap counts = overlap(a, b);
+    if (counts.union_count == 0)
+    {
+        return 1.0;
+    }
+    return static_cast<double>(counts.intersection) / static_cast<double>(counts.union_count);
+}
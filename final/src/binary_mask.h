@@ -0,0 +1,176 @@
+/**
+ * @file binary_mask.h
+ * @author sunfu-chou (sunfu-chou@gmail.com)
+ * @brief This file contains the declaration of the BinaryMask class, a segmentation mask packed to one bit per
+ * pixel, and of the popcount kernels that compare two masks.
+ * @version 0.1
+ * @date 2024-01-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef BINARY_MASK_H
+#define BINARY_MASK_H
+
+#include <filesystem>
+#include <iosfwd>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "mask.h"
+
+struct BMPFileHeader;
+struct BMPInfoHeader;
+
+/**
+ * @brief A binary mask packed to one bit per pixel.
+ * Each row is padded to whole 64-bit words, and pixel x of a row is bit x % 64 of word x / 64. The bits past
+ * the width are always 0, so the kernels can work on whole words. As with Mask, the rows are stored bottom-up.
+ */
+class BinaryMask
+{
+  private:
+    int width;
+    int height;
+    size_t words_per_row;
+    std::vector<uint64_t> data;
+
+    /**
+     * @brief Reads the palette and pixels of a 1-bpp BMP file; a pixel is foreground when its palette color is
+     * the brighter one.
+     *
+     * @param file The file, positioned anywhere after the headers.
+     * @param header The file header.
+     * @param info_header The info header.
+     */
+    void readPacked(std::istream& file, const BMPFileHeader& header, const BMPInfoHeader& info_header);
+
+  public:
+    /**
+     * @brief Construct a new BinaryMask object filled with one value.
+     *
+     * @param width The width of the mask.
+     * @param height The height of the mask.
+     * @param value The initial value of every pixel.
+     */
+    BinaryMask(int width, int height, bool value = false);
+
+    /**
+     * @brief Construct a new BinaryMask object from the nonzero pixels of a mask.
+     *
+     * @param mask The mask to pack.
+     */
+    explicit BinaryMask(const Mask& mask);
+
+    /**
+     * @brief Construct a new BinaryMask object from a BMP file.
+     * 1-bpp files are read directly; 24-bit and 32-bit files are read as a Mask and thresholded.
+     *
+     * @param filename The name of the BMP file to read.
+     * @param level The threshold level for 24-bit and 32-bit files: values above it are foreground.
+     */
+    explicit BinaryMask(const std::filesystem::path& filename, uint8_t level = 128);
+
+    /**
+     * @brief Writes the mask to a 1-bpp BMP file with a black and white palette.
+     *
+     * @param filename The name of the BMP file to write.
+     */
+    void write(const std::filesystem::path& filename) const;
+
+    /**
+     * @brief Unpacks the mask to bytes, 255 for foreground and 0 for background.
+     *
+     */
+    Mask toMask() const;
+
+    int getWidth() const;
+    int getHeight() const;
+    size_t getWordsPerRow() const;
+
+    /**
+     * @brief Returns a pointer to the first word of a row.
+     *
+     * @param y The row index.
+     */
+    uint64_t* row(int y);
+    const uint64_t* row(int y) const;
+
+    /**
+     * @brief Clears the bits past the width of every row. Call it after writing whole words through row().
+     *
+     */
+    void clearPadding();
+
+    /**
+     * @brief Packs a row of bytes into a row of the mask.
+     *
+     * @param y The row index.
+     * @param pixels The width bytes of the row.
+     * @param level The threshold level: bytes above it are foreground.
+     */
+    void packRow(int y, const uint8_t* pixels, uint8_t level = 0);
+
+    bool get(int x, int y) const;
+    void set(int x, int y, bool value);
+
+    /**
+     * @brief Counts the foreground pixels.
+     *
+     */
+    size_t count() const;
+
+    /**
+     * @brief Inverts every pixel.
+     *
+     */
+    void invert();
+
+    /**
+     * @brief Combines the mask with another mask of the same size, pixel by pixel.
+     *
+     * @param other The other mask.
+     * @return A reference to this mask.
+     */
+    BinaryMask& operator&=(const BinaryMask& other);
+    BinaryMask& operator|=(const BinaryMask& other);
+    BinaryMask& operator^=(const BinaryMask& other);
+};
+
+/**
+ * @brief The Overlap struct holds the pixel counts of two masks compared with each other.
+ * - intersection: pixels that are foreground in both masks
+ * - union_count: pixels that are foreground in either mask
+ * - first, second: the foreground pixels of each mask
+ *
+ */
+struct Overlap
+{
+    size_t intersection;
+    size_t union_count;
+    size_t first;
+    size_t second;
+};
+
+/**
+ * @brief Counts the overlap of two masks of the same size in one pass over both.
+ *
+ * @param a The first mask.
+ * @param b The second mask.
+ * @return The pixel counts.
+ */
+Overlap overlap(const BinaryMask& a, const BinaryMask& b);
+
+/**
+ * @brief Computes the intersection over union of two masks of the same size.
+ * Two empty masks are identical, so their IoU is 1.
+ *
+ * @param a The first mask.
+ * @param b The second mask.
+ * @return The IoU in [0, 1].
+ */
+double iou(const BinaryMask& a, const BinaryMask& b);
+
+#endif  // BINARY_MASK_H
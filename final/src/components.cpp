@@ -0,0 +1,217 @@
+/**
+ * @file components.cpp
+ * @author sunfu-chou (sunfu-chou@gmail.com)
+ * @brief This file contains the implementation of the connected-component labeling of masks.
+ * @version 0.1
+ * @date 2024-01-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "components.h"
+
+#include <algorithm>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+/**
+ * @brief A horizontal run of foreground pixels [begin, end) in row y.
+ * parent links the runs of one component into a union-find forest.
+ */
+struct Run
+{
+    int y;
+    int begin;
+    int end;
+    int parent;
+};
+
+/**
+ * @brief Returns the position of the first pixel at or after x that is (or is not) foreground.
+ * Uniform 16-pixel blocks are skipped at once, which makes long background and foreground stretches cheap.
+ */
+int findNext(const uint8_t* row, int x, int width, bool foreground)
+{
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    // The movemask is 0xFFFF for an all-background block and 0 for an all-foreground one
+    const int skip = foreground ? 0xFFFF : 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, zero)) != skip)
+        {
+            break;
+        }
+    }
+#endif
+    while (x < width && (row[x] != 0) != foreground)
+    {
+        ++x;
+    }
+    return x;
+}
+
+int findRoot(std::vector<Run>& runs, int i)
+{
+    int root = i;
+    while (runs[root].parent != root)
+    {
+        root = runs[root].parent;
+    }
+    // Path compression
+    while (runs[i].parent != root)
+    {
+        int next = runs[i].parent;
+        runs[i].parent = root;
+        i = next;
+    }
+    return root;
+}
+
+/**
+ * @brief Joins two sets, keeping the earlier run as the root so that labels follow the raster order.
+ */
+void unite(std::vector<Run>& runs, int a, int b)
+{
+    a = findRoot(runs, a);
+    b = findRoot(runs, b);
+    if (a < b)
+    {
+        runs[b].parent = a;
+    }
+    else if (b < a)
+    {
+        runs[a].parent = b;
+    }
+}
+
+/**
+ * @brief First pass: extracts the runs of every row and unites the runs that touch in consecutive rows.
+ */
+std::vector<Run> collectRuns(const Mask& mask, Connectivity connectivity)
+{
+    int width = mask.getWidth();
+    int height = mask.getHeight();
+    // With 8-connectivity runs that only touch at a corner are joined too
+    int reach = (connectivity == Connectivity::Eight) ? 1 : 0;
+
+    std::vector<Run> runs;
+    size_t previous_begin = 0;
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t* row = mask.row(y);
+        size_t current_begin = runs.size();
+        size_t above = previous_begin;
+        for (int x = findNext(row, 0, width, true); x < width; x = findNext(row, x, width, true))
+        {
+            int end = findNext(row, x, width, false);
+            int index = static_cast<int>(runs.size());
+            runs.push_back(Run{ y, x, end, index });
+
+            // Runs of the previous row are sorted, so the overlapping ones form a window that only moves right
+            while (above < current_begin && runs[above].end + reach <= x)
+            {
+                ++above;
+            }
+            for (size_t i = above; i < current_begin && runs[i].begin < end + reach; ++i)
+            {
+                unite(runs, static_cast<int>(i), index);
+            }
+            x = end;
+        }
+        previous_begin = current_begin;
+    }
+    return runs;
+}
+
+/**
+ * @brief Second pass: gives every root a label in raster order and accumulates the component statistics.
+ * On return the parent field of every run holds its zero-based component index.
+ */
+std::vector<Component> resolveComponents(std::vector<Run>& runs)
+{
+    std::vector<Component> components;
+    std::vector<double> sum_x, sum_y;
+    std::vector<int> component_of(runs.size());
+    for (size_t i = 0; i < runs.size(); ++i)
+    {
+        Run& run = runs[i];
+        // A parent never comes after its child, so one forward sweep flattens every tree
+        int root = runs[run.parent].parent;
+        run.parent = root;
+        if (root == static_cast<int>(i))
+        {
+            component_of[i] = static_cast<int>(components.size());
+            components.push_back(Component{ component_of[i] + 1, 0, run.begin, run.y, run.end - 1, run.y, 0.0, 0.0 });
+            sum_x.push_back(0.0);
+            sum_y.push_back(0.0);
+        }
+        int index = component_of[i] = component_of[root];
+
+        Component& component = components[index];
+        size_t length = static_cast<size_t>(run.end - run.begin);
+        component.area += length;
+        component.min_x = std::min(component.min_x, run.begin);
+        component.max_x = std::max(component.max_x, run.end - 1);
+        component.max_y = run.y;
+        // Sum of x over [begin, end)
+        sum_x[index] += 0.5 * static_cast<double>(length) * (run.begin + run.end - 1);
+        sum_y[index] += static_cast<double>(length) * run.y;
+    }
+    for (size_t i = 0; i < runs.size(); ++i)
+    {
+        runs[i].parent = component_of[i];
+    }
+    for (size_t i = 0; i < components.size(); ++i)
+    {
+        components[i].centroid_x = sum_x[i] / static_cast<double>(components[i].area);
+        components[i].centroid_y = sum_y[i] / static_cast<double>(components[i].area);
+    }
+    return components;
+}
+}  // namespace
+
+std::vector<Component> findComponents(const Mask& mask, Connectivity connectivity)
+{
+    std::vector<Run> runs = collectRuns(mask, connectivity);
+    return resolveComponents(runs);
+}
+
+std::vector<Component> labelComponents(const Mask& mask, std::vector<int32_t>& labels, Connectivity connectivity)
+{
+    std::vector<Run> runs = collectRuns(mask, connectivity);
+    std::vector<Component> components = resolveComponents(runs);
+
+    int width = mask.getWidth();
+    labels.assign(static_cast<size_t>(width) * mask.getHeight(), 0);
+    for (const Run& run : runs)
+    {
+        int32_t* row = &labels[static_cast<size_t>(run.y) * width];
+        std::fill(row + run.begin, row + run.end, run.parent + 1);
+    }
+    return components;
+}
+
+size_t removeSmallComponents(Mask& mask, size_t min_area, Connectivity connectivity)
+{
+    std::vector<Run> runs = collectRuns(mask, connectivity);
+    std::vector<Component> components = resolveComponents(runs);
+
+    for (const Run& run : runs)
+    {
+        if (components[run.parent].area < min_area)
+        {
+            uint8_t* row = mask.row(run.y);
+            std::fill(row + run.begin, row + run.end, 0);
+        }
+    }
+    return static_cast<size_t>(std::count_if(components.begin(), components.end(),
+                                             [min_area](const Component& component) { return component.area < min_area; }));
+}
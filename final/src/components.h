@@ -0,0 +1,82 @@
+/**
+ * @file components.h
+ * @author sunfu-chou (sunfu-chou@gmail.com)
+ * @brief This file contains the declarations of the connected-component labeling of masks.
+ * Components are found with a two-pass union-find over the foreground runs of each row, so the cost grows
+ * with the number of runs rather than the number of pixels, and the region statistics come from the runs.
+ * @version 0.1
+ * @date 2024-01-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "mask.h"
+
+/**
+ * @brief The Connectivity enum selects which neighbors join two foreground pixels.
+ * - Four: the left, right, upper and lower neighbors
+ * - Eight: the four neighbors and the four diagonal neighbors
+ *
+ */
+enum class Connectivity
+{
+    Four,
+    Eight
+};
+
+/**
+ * @brief The Component struct holds the statistics of one connected component.
+ * Coordinates are mask coordinates, so y counts the rows as stored (bottom-up for masks read from BMP files).
+ * - label: the label of the component, from 1 in the order the components are first met
+ * - area: the number of pixels
+ * - min_x, min_y, max_x, max_y: the inclusive bounding box
+ * - centroid_x, centroid_y: the mean pixel position
+ *
+ */
+struct Component
+{
+    int label;
+    size_t area;
+    int min_x, min_y, max_x, max_y;
+    double centroid_x, centroid_y;
+};
+
+/**
+ * @brief Finds the connected components of the nonzero pixels of a mask.
+ *
+ * @param mask The mask to label.
+ * @param connectivity The pixel connectivity.
+ * @return The components, ordered by label.
+ */
+std::vector<Component> findComponents(const Mask& mask, Connectivity connectivity = Connectivity::Eight);
+
+/**
+ * @brief Finds the connected components of a mask and writes a label image.
+ *
+ * @param mask The mask to label.
+ * @param labels Receives width * height labels in the row order of the mask; 0 marks the background.
+ * @param connectivity The pixel connectivity.
+ * @return The components, ordered by label.
+ */
+std::vector<Component> labelComponents(const Mask& mask, std::vector<int32_t>& labels,
+                                       Connectivity connectivity = Connectivity::Eight);
+
+/**
+ * @brief Clears every component smaller than a minimum area.
+ *
+ * @param mask The mask to clean in place.
+ * @param min_area The smallest area that is kept.
+ * @param connectivity The pixel connectivity.
+ * @return The number of components removed.
+ */
+size_t removeSmallComponents(Mask& mask, size_t min_area, Connectivity connectivity = Connectivity::Eight);
+
+#endif  // COMPONENTS_H
@@ -0,0 +1,282 @@
+/**
+ * @file evaluate_masks.cpp
+ * @author sunfu-chou (sunfu-chou@gmail.com)
+ * @brief Evaluates a directory of predicted masks against a directory of ground-truth masks.
+ * The masks are decoded in parallel, thresholded, packed to one bit per pixel and compared with popcount
+ * kernels; the per-image and aggregate IoU, Dice, precision, recall and pixel accuracy are written as CSV or JSON.
+ * @version 0.1
+ * @date 2024-01-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "binary_mask.h"
+#include "bmp.h"
+#include "evaluation.h"
+#include "image_io.h"
+#include "mask.h"
+
+namespace
+{
+/**
+ * @brief A predicted mask, its ground truth and their comparison.
+ */
+struct Pair
+{
+    std::filesystem::path prediction;
+    std::filesystem::path ground_truth;
+    Confusion counts;
+    Scores metrics;
+    std::string error;
+};
+
+std::string jsonString(const std::string& text)
+{
+    std::string quoted = "\"";
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+void writeScores(std::ostream& out, const Scores& metrics)
+{
+    out << "\"iou\": " << metrics.iou << ", \"dice\": " << metrics.dice << ", \"precision\": " << metrics.precision
+        << ", \"recall\": " << metrics.recall << ", \"accuracy\": " << metrics.accuracy;
+}
+
+void writeCsv(const std::filesystem::path& filename, const std::vector<Pair>& pairs)
+{
+    std::ofstream csv(filename);
+    if (!csv)
+    {
+        throw std::filesystem::filesystem_error("Unable to open file", filename, std::make_error_code(std::io_errc::stream));
+    }
+    csv << std::fixed << std::setprecision(6);
+    csv << "prediction,ground_truth,true_positive,false_positive,false_negative,true_negative,iou,dice,precision,recall,"
+           "accuracy\n";
+    for (const Pair& pair : pairs)
+    {
+        if (!pair.error.empty())
+        {
+            continue;
+        }
+        csv << pair.prediction.filename().string() << ',' << pair.ground_truth.filename().string() << ','
+            << pair.counts.true_positive << ',' << pair.counts.false_positive << ',' << pair.counts.false_negative << ','
+            << pair.counts.true_negative << ',' << pair.metrics.iou << ',' << pair.metrics.dice << ',' << pair.metrics.precision
+            << ',' << pair.metrics.recall << ',' << pair.metrics.accuracy << '\n';
+    }
+}
+
+void writeJson(const std::filesystem::path& filename, const std::vector<Pair>& pairs, const Scores& mean, const Scores& pooled)
+{
+    std::ofstream json(filename);
+    if (!json)
+    {
+        throw std::filesystem::filesystem_error("Unable to open file", filename, std::make_error_code(std::io_errc::stream));
+    }
+    json << std::fixed << std::setprecision(6);
+    json << "{\n  \"images\": [";
+    bool first = true;
+    for (const Pair& pair : pairs)
+    {
+        if (!pair.error.empty())
+        {
+            continue;
+        }
+        json << (first ? "\n" : ",\n") << "    { \"prediction\": " << jsonString(pair.prediction.filename().string())
+             << ", \"ground_truth\": " << jsonString(pair.ground_truth.filename().string()) << ", ";
+        writeScores(json, pair.metrics);
+        json << " }";
+        first = false;
+    }
+    json << "\n  ],\n  \"mean\": { ";
+    writeScores(json, mean);
+    json << " },\n  \"pooled\": { ";
+    writeScores(json, pooled);
+    json << " }\n}\n";
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <prediction_dir> <ground_truth_dir> [--threshold level] [--prediction-prefix prefix] "
+                     "[--ground-truth-prefix prefix] [--csv file] [--json file]"
+                  << std::endl;
+        return 1;
+    }
+
+    std::filesystem::path prediction_dir(argv[1]);
+    std::filesystem::path ground_truth_dir(argv[2]);
+    uint8_t level = 128;
+    std::string prediction_prefix;
+    std::string ground_truth_prefix;
+    std::filesystem::path csv_filename;
+    std::filesystem::path json_filename;
+    try
+    {
+        for (int i = 3; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--threshold" && i + 1 < argc)
+            {
+                level = parseThresholdLevel(argv[++i]);
+            }
+            else if (arg == "--prediction-prefix" && i + 1 < argc)
+            {
+                prediction_prefix = argv[++i];
+            }
+            else if (arg == "--ground-truth-prefix" && i + 1 < argc)
+            {
+                ground_truth_prefix = argv[++i];
+            }
+            else if (arg == "--csv" && i + 1 < argc)
+            {
+                csv_filename = argv[++i];
+            }
+            else if (arg == "--json" && i + 1 < argc)
+            {
+                json_filename = argv[++i];
+            }
+            else
+            {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::vector<Pair> pairs;
+    try
+    {
+        auto predictions = listImages(prediction_dir, prediction_prefix);
+        auto ground_truths = listImages(ground_truth_dir, ground_truth_prefix);
+        for (const auto& [key, prediction] : predictions)
+        {
+            auto ground_truth = ground_truths.find(key);
+            if (ground_truth == ground_truths.end())
+            {
+                std::cerr << YELLOW << "No ground truth for " << prediction << RESET << std::endl;
+                continue;
+            }
+            pairs.push_back(Pair{ prediction, ground_truth->second, {}, {}, {} });
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    if (pairs.empty())
+    {
+        std::cerr << "Error: No mask pairs found" << std::endl;
+        return 1;
+    }
+
+    // Decoding dominates, so every worker takes whole pairs; the popcount comparison itself runs at memory speed
+    std::atomic<size_t> next{ 0 };
+    auto worker = [&]() {
+        for (size_t i = next++; i < pairs.size(); i = next++)
+        {
+            Pair& pair = pairs[i];
+            try
+            {
+                BinaryMask prediction = readBinaryMask(pair.prediction, level);
+                BinaryMask ground_truth = readBinaryMask(pair.ground_truth, level);
+                pair.counts = confusion(prediction, ground_truth);
+                pair.metrics = scores(pair.counts);
+            }
+            catch (const std::exception& e)
+            {
+                pair.error = e.what();
+            }
+        }
+    };
+    size_t thread_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), pairs.size());
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < thread_count; ++t)
+    {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers)
+    {
+        thread.join();
+    }
+
+    // The mean weighs every image the same; the pooled scores add up the pixels of all images first
+    std::vector<Scores> per_image;
+    Confusion total;
+    int failed = 0;
+    std::cout << std::fixed << std::setprecision(6);
+    for (const Pair& pair : pairs)
+    {
+        if (!pair.error.empty())
+        {
+            std::cerr << RED << "Error: " << pair.prediction << ": " << pair.error << RESET << std::endl;
+            ++failed;
+            continue;
+        }
+        per_image.push_back(pair.metrics);
+        total += pair.counts;
+        std::cout << "IoU for " << pair.prediction.filename().string() << ": " << pair.metrics.iou << std::endl;
+    }
+    Scores mean = meanScores(per_image);
+    Scores pooled = scores(total);
+    std::cout << "Average IoU      : " << mean.iou << std::endl;
+    std::cout << "Average Dice     : " << mean.dice << std::endl;
+    std::cout << "Average precision: " << mean.precision << std::endl;
+    std::cout << "Average recall   : " << mean.recall << std::endl;
+    std::cout << "Average accuracy : " << mean.accuracy << std::endl;
+    std::cout << "Pooled IoU       : " << pooled.iou << std::endl;
+
+    try
+    {
+        if (!csv_filename.empty())
+        {
+            writeCsv(csv_filename, pairs);
+        }
+        if (!json_filename.empty())
+        {
+            writeJson(json_filename, pairs, mean, pooled);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    if (failed > 0)
+    {
+        std::cerr << RED << failed << " of " << pairs.size() << " pairs failed" << RESET << std::endl;
+        return 1;
+    }
+    std::cout << GREEN << "Evaluated " << pairs.size() << " mask pairs successfully!" << RESET << std::endl;
+    return 0;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file evaluation.cpp
+ * @author sunfu-chou (sunfu-chou@gmail.com)
+ * @brief This file contains the implementation of the segmentation metrics.
+ * @version 0.1
+ * @date 2024-01-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "evaluation.h"
+
+#include <vector>
+
+namespace
+{
+/**
+ * @brief Divides two counts; an empty denominator gives 1 when the numerator is empty as well, and 0 otherwise.
+ */
+double ratio(size_t numerator, size_t denominator, bool agree)
+{
+    if (denominator == 0)
+    {
+        return agree ? 1.0 : 0.0;
+    }
+    return static_cast<double>(numerator) / static_cast<double>(denominator);
+}
+}  // namespace
+
+Confusion& Confusion::operator+=(const Confusion& other)
+{
+    true_positive += other.true_positive;
+    false_positive += other.false_positive;
+    false_negative += other.false_negative;
+    true_negative += other.true_negative;
+    return *this;
+}
+
+Confusion confusion(const BinaryMask& prediction, const BinaryMask& ground_truth)
+{
+    Overlap counts = overlap(prediction, ground_truth);
+    size_t total = static_cast<size_t>(prediction.getWidth()) * prediction.getHeight();
+
+    Confusion result;
+    result.true_positive = counts.intersection;
+    result.false_positive = counts.first - counts.intersection;
+    result.false_negative = counts.second - counts.intersection;
+    result.true_negative = total - counts.union_count;
+    return result;
+}
+
+Scores scores(const Confusion& counts)
+{
+    size_t predicted = counts.true_positive + counts.false_positive;
+    size_t actual = counts.true_positive + counts.false_negative;
+    size_t union_count = counts.true_positive + counts.false_positive + counts.false_negative;
+    size_t total = union_count + counts.true_negative;
+
+    Scores result;
+    result.iou = ratio(counts.true_positive, union_count, true);
+    result.dice = ratio(2 * counts.true_positive, predicted + actual, true);
+    result.precision = ratio(counts.true_positive, predicted, actual == 0);
+    result.recall = ratio(counts.true_positive, actual, predicted == 0);
+    result.accuracy = ratio(counts.true_positive + counts.true_negative, total, true);
+    return result;
+}
+
+Scores meanScores(const std::vector<Scores>& per_image)
+{
+    Scores mean{ 0.0, 0.0, 0.0, 0.0, 0.0 };
+    if (per_image.empty())
+    {
+        return mean;
+    }
+    for (const Scores& image : per_image)
+    {
+        mean.iou += image.iou;
+        mean.dice += image.dice;
+        mean.precision += image.precision;
+        mean.recall += image.recall;
+        mean.accuracy += image.accuracy;
+    }
+    double count = static_cast<double>(per_image.size());
+    mean.iou /= count;
+    mean.dice /= count;
+    mean.precision /= count;
+    mean.recall /= count;
+    mean.accuracy /= count;
+    return mean;
+}
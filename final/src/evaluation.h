@@ -0,0 +1,78 @@
+/**
+ * @file evaluation.h
+ * @author sunfu-chou (sunfu-chou@gmail.com)
+ * @brief This file contains the declarations of the segmentation metrics that compare a predicted mask with its
+ * ground truth.
+ * @version 0.1
+ * @date 2024-01-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include <stddef.h>
+#include <vector>
+
+#include "binary_mask.h"
+
+/**
+ * @brief The Confusion struct holds the pixel counts of a prediction against its ground truth.
+ * - true_positive: foreground in both masks
+ * - false_positive: foreground in the prediction only
+ * - false_negative: foreground in the ground truth only
+ * - true_negative: background in both masks
+ *
+ */
+struct Confusion
+{
+    size_t true_positive = 0;
+    size_t false_positive = 0;
+    size_t false_negative = 0;
+    size_t true_negative = 0;
+
+    Confusion& operator+=(const Confusion& other);
+};
+
+/**
+ * @brief The Scores struct holds the metrics derived from a confusion.
+ * A metric whose denominator is zero is 1 when the masks agree (for example both are empty) and 0 otherwise.
+ *
+ */
+struct Scores
+{
+    double iou;
+    double dice;
+    double precision;
+    double recall;
+    double accuracy;
+};
+
+/**
+ * @brief Counts the confusion of a prediction against its ground truth with the popcount kernels.
+ *
+ * @param prediction The predicted mask.
+ * @param ground_truth The ground-truth mask of the same size.
+ * @return The pixel counts.
+ */
+Confusion confusion(const BinaryMask& prediction, const BinaryMask& ground_truth);
+
+/**
+ * @brief Derives the metrics from a confusion.
+ *
+ * @param counts The pixel counts.
+ * @return The metrics.
+ */
+Scores scores(const Confusion& counts);
+
+/**
+ * @brief Averages the metrics of several images, each image weighing the same (as demo_evaluation.py does).
+ *
+ * @param per_image The metrics of every image.
+ * @return The mean metrics, or zeros when there are no images.
+ */
+Scores meanScores(const std::vector<Scores>& per_image);
+
+#endif  // EVALUATION_H
@@ -0,0 +1,167 @@
+/**
+ * @file image_io.cpp
+ * @author sunfu-chou (sunfu-chou@gmail.com)
+ * @brief This file contains the implementation of the file helpers shared by the dataset tools.
+ * @version 0.1
+ * @date 2024-01-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "image_io.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "opencv2/core/mat.hpp"
+#include "opencv2/imgcodecs.hpp"
+
+namespace
+{
+std::string lowerExtension(const std::filesystem::path& filename)
+{
+    std::string extension = filename.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+    return extension;
+}
+
+cv::Mat decode(const std::filesystem::path& filename, int flags)
+{
+    cv::Mat image = cv::imread(filename.string(), flags);
+    if (image.empty())
+    {
+        throw std::filesystem::filesystem_error("Unable to decode image", filename, std::make_error_code(std::io_errc::stream));
+    }
+    return image;
+}
+}  // namespace
+
+BMPImage readImage(const std::filesystem::path& filename)
+{
+    if (lowerExtension(filename) == ".bmp")
+    {
+        return BMPImage(filename);
+    }
+
+    // OpenCV decodes to BGR, which is the byte order of BMP pixels; its rows are top-down
+    cv::Mat decoded = decode(filename, cv::IMREAD_COLOR);
+    BMPImage image(decoded.cols, decoded.rows);
+    for (int y = 0; y < decoded.rows; ++y)
+    {
+        const uint8_t* in = decoded.ptr<uint8_t>(y);
+        Pixel* out = image.row(decoded.rows - 1 - y);
+        for (int x = 0; x < decoded.cols; ++x)
+        {
+            out[x] = Pixel{ in[3 * x], in[3 * x + 1], in[3 * x + 2], 255 };
+        }
+    }
+    return image;
+}
+
+void writeImage(BMPImage& image, const std::filesystem::path& filename)
+{
+    if (lowerExtension(filename) == ".bmp")
+    {
+        image.write(filename);
+        return;
+    }
+
+    int height = image.getHeight();
+    cv::Mat encoded(height, image.getWidth(), CV_8UC3);
+    for (int y = 0; y < height; ++y)
+    {
+        const Pixel* in = image.row(height - 1 - y);
+        uint8_t* out = encoded.ptr<uint8_t>(y);
+        for (int x = 0; x < encoded.cols; ++x)
+        {
+            out[3 * x] = in[x].r;
+            out[3 * x + 1] = in[x].g;
+            out[3 * x + 2] = in[x].b;
+        }
+    }
+    if (!cv::imwrite(filename.string(), encoded))
+    {
+        throw std::filesystem::filesystem_error("Unable to encode image", filename, std::make_error_code(std::io_errc::stream));
+    }
+}
+
+Mask readMask(const std::filesystem::path& filename)
+{
+    if (lowerExtension(filename) == ".bmp")
+    {
+        return Mask(filename);
+    }
+
+    cv::Mat decoded = decode(filename, cv::IMREAD_GRAYSCALE);
+    Mask mask(decoded.cols, decoded.rows);
+    for (int y = 0; y < decoded.rows; ++y)
+    {
+        const uint8_t* in = decoded.ptr<uint8_t>(y);
+        std::copy(in, in + decoded.cols, mask.row(decoded.rows - 1 - y));
+    }
+    return mask;
+}
+
+BinaryMask readBinaryMask(const std::filesystem::path& filename, uint8_t level)
+{
+    if (lowerExtension(filename) == ".bmp")
+    {
+        return BinaryMask(filename, level);
+    }
+
+    // Pack straight from the decoded rows, without an intermediate byte mask
+    cv::Mat decoded = decode(filename, cv::IMREAD_GRAYSCALE);
+    BinaryMask mask(decoded.cols, decoded.rows);
+    for (int y = 0; y < decoded.rows; ++y)
+    {
+        mask.packRow(decoded.rows - 1 - y, decoded.ptr<uint8_t>(y), level);
+    }
+    return mask;
+}
+
+std::string pairKey(const std::filesystem::path& filename, const std::string& prefix)
+{
+    std::string stem = filename.stem().string();
+    stem.erase(0, std::min(prefix.size(), stem.size()));
+    size_t digits = stem.size();
+    while (digits > 0 && std::isdigit(static_cast<unsigned char>(stem[digits - 1])))
+    {
+        --digits;
+    }
+    // With a prefix the whole remainder must be a number to be compared by value
+    if (digits == stem.size() || (!prefix.empty() && digits != 0))
+    {
+        return stem;
+    }
+    // Compare numbers by value so that 7 and 007 pair up
+    std::string number = stem.substr(digits);
+    number.erase(0, std::min(number.find_first_not_of('0'), number.size() - 1));
+    return "#" + number;
+}
+
+std::map<std::string, std::filesystem::path> listImages(const std::filesystem::path& directory, const std::string& prefix)
+{
+    const std::vector<std::string> extensions{ ".bmp", ".jpg", ".jpeg", ".png", ".tif", ".tiff" };
+    std::map<std::string, std::filesystem::path> images;
+    for (const auto& entry : std::filesystem::directory_iterator(directory))
+    {
+        std::string extension = lowerExtension(entry.path());
+        if (!entry.is_regular_file() || std::find(extensions.begin(), extensions.end(), extension) == extensions.end() ||
+            entry.path().stem().string().compare(0, prefix.size(), prefix) != 0)
+        {
+            continue;
+        }
+        std::string key = pairKey(entry.path(), prefix);
+        auto [existing, inserted] = images.emplace(key, entry.path());
+        if (!inserted)
+        {
+            throw std::invalid_argument("Ambiguous file names: " + existing->second.string() + " and " + entry.path().string());
+        }
+    }
+    return images;
+}
@@ -0,0 +1,80 @@
+/**
+ * @file image_io.h
+ * @author sunfu-chou (sunfu-chou@gmail.com)
+ * @brief This file contains the declarations of the file helpers shared by the dataset tools.
+ * BMP files are handled natively; the JPEG and PNG files of the dataset are decoded and encoded with OpenCV.
+ * Every image and mask keeps the bottom-up row order of BMPImage, whatever its file format.
+ * @version 0.1
+ * @date 2024-01-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef IMAGE_IO_H
+#define IMAGE_IO_H
+
+#include <filesystem>
+#include <map>
+#include <stdint.h>
+#include <string>
+
+#include "binary_mask.h"
+#include "bmp.h"
+#include "mask.h"
+
+/**
+ * @brief Reads a color image.
+ *
+ * @param filename The name of the image file to read.
+ * @return The image, with the channels in BMP byte order.
+ */
+BMPImage readImage(const std::filesystem::path& filename);
+
+/**
+ * @brief Writes a color image; the format follows the file extension.
+ *
+ * @param image The image to write.
+ * @param filename The name of the image file to write.
+ */
+void writeImage(BMPImage& image, const std::filesystem::path& filename);
+
+/**
+ * @brief Reads a grayscale mask.
+ *
+ * @param filename The name of the mask file to read.
+ * @return The mask.
+ */
+Mask readMask(const std::filesystem::path& filename);
+
+/**
+ * @brief Reads a mask and packs the pixels above a level.
+ *
+ * @param filename The name of the mask file to read.
+ * @param level The threshold level.
+ * @return The packed mask.
+ */
+BinaryMask readBinaryMask(const std::filesystem::path& filename, uint8_t level);
+
+/**
+ * @brief Returns the key that pairs a file with its counterpart in another directory. The prefix is removed from
+ * the file stem; a remaining number is compared by value (input3.jpg with prefix "input" pairs with output003.jpg
+ * with prefix "output"). Without a prefix, a stem that ends in a number is keyed by that number alone.
+ *
+ * @param filename The file name.
+ * @param prefix The prefix of the stem, or empty.
+ */
+std::string pairKey(const std::filesystem::path& filename, const std::string& prefix = "");
+
+/**
+ * @brief Lists the image files (BMP, JPEG, PNG, TIFF) of a directory whose stem starts with a prefix, by their
+ * pairing keys.
+ *
+ * @param directory The directory to list.
+ * @param prefix The prefix of the stems to list, or empty to list every image.
+ * @return The files by key.
+ * @throw std::invalid_argument if two files share a key.
+ */
+std::map<std::string, std::filesystem::path> listImages(const std::filesystem::path& directory, const std::string& prefix = "");
+
+#endif  // IMAGE_IO_H
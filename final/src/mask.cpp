@@ -0,0 +1,149 @@
+/**
+ * @file mask.cpp
+ * @author sunfu-chou (sunfu-chou@gmail.com)
+ * @brief This file contains the implementation of the Mask class.
+ * @version 0.1
+ * @date 2024-01-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "mask.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "binary_mask.h"
+#include "bmp.h"
+
+Mask::Mask(int width, int height, uint8_t value) : width(width), height(height)
+{
+    if (width <= 0 || height <= 0)
+    {
+        throw std::invalid_argument("Mask size must be positive");
+    }
+    data.assign(static_cast<size_t>(width) * height, value);
+}
+
+Mask::Mask(const BMPImage& image) : Mask(image.getWidth(), image.getHeight())
+{
+    for (int y = 0; y < height; ++y)
+    {
+        uint8_t* out = row(y);
+        for (int x = 0; x < width; ++x)
+        {
+            Pixel pixel = image.getPixel(x, y);
+            out[x] = static_cast<uint8_t>((pixel.r + pixel.g + pixel.b) / 3);
+        }
+    }
+}
+
+Mask::Mask(const std::filesystem::path& filename) : width(0), height(0)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        throw std::filesystem::filesystem_error("Unable to open file", filename, std::make_error_code(std::io_errc::stream));
+    }
+    BMPFileHeader header{};
+    BMPInfoHeader info_header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    file.read(reinterpret_cast<char*>(&info_header), sizeof(info_header));
+    file.close();
+
+    // Packed masks are unpacked; everything else goes through the image reader
+    *this = (info_header.bit_count == 1) ? BinaryMask(filename).toMask() : Mask(BMPImage(filename));
+}
+
+void Mask::write(const std::filesystem::path& filename) const
+{
+    std::ofstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        throw std::filesystem::filesystem_error("Unable to open file", filename, std::make_error_code(std::io_errc::stream));
+    }
+
+    int row_size = (width * 3 + 3) / 4 * 4;
+
+    BMPInfoHeader info_header{};
+    info_header.size = sizeof(BMPInfoHeader);
+    info_header.width = width;
+    info_header.height = height;
+    info_header.planes = 1;
+    info_header.bit_count = 24;
+    info_header.image_size = static_cast<uint32_t>(row_size) * height;
+
+    BMPFileHeader header{};
+    header.type = 0x4D42;
+    header.offset = sizeof(BMPFileHeader) + sizeof(BMPInfoHeader);
+    header.size = header.offset + info_header.image_size;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(&info_header), sizeof(info_header));
+
+    std::vector<uint8_t> bytes(row_size, 0);
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t* in = row(y);
+        for (int x = 0; x < width; ++x)
+        {
+            std::fill_n(&bytes[3 * x], 3, in[x]);
+        }
+        file.write(reinterpret_cast<const char*>(bytes.data()), row_size);
+    }
+}
+
+int Mask::getWidth() const
+{
+    return width;
+}
+
+int Mask::getHeight() const
+{
+    return height;
+}
+
+uint8_t* Mask::row(int y)
+{
+    return &data[static_cast<size_t>(y) * width];
+}
+
+const uint8_t* Mask::row(int y) const
+{
+    return &data[static_cast<size_t>(y) * width];
+}
+
+void Mask::threshold(uint8_t level)
+{
+    for (uint8_t& value : data)
+    {
+        value = (value > level) ? 255 : 0;
+    }
+}
+
+bool Mask::isBinary() const
+{
+    return std::all_of(data.begin(), data.end(), [](uint8_t value) { return value == 0 || value == 255; });
+}
+
+uint8_t parseThresholdLevel(const std::string& text)
+{
+    size_t end = 0;
+    int level = -1;
+    try
+    {
+        level = std::stoi(text, &end);
+    }
+    catch (const std::logic_error&)
+    {
+        // Not a number, or out of the range of int; rejected below
+    }
+    if (end != text.size() || level < 0 || level > 255)
+    {
+        throw std::invalid_argument("Threshold level must be an integer from 0 to 255: " + text);
+    }
+    return static_cast<uint8_t>(level);
+}
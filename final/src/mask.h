@@ -0,0 +1,100 @@
+/**
+ * @file mask.h
+ * @author sunfu-chou (sunfu-chou@gmail.com)
+ * @brief This file contains the declaration of the Mask class, a single-channel 8-bit image that holds a
+ * segmentation mask.
+ * @version 0.1
+ * @date 2024-01-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef MASK_H
+#define MASK_H
+
+#include <filesystem>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class BMPImage;
+
+/**
+ * @brief A single-channel 8-bit mask.
+ * The rows are stored in the row order of the BMP image the mask was read from (bottom-up), so a mask and
+ * the image it belongs to share their coordinates. Binary masks hold 0 for background and 255 for foreground.
+ */
+class Mask
+{
+  private:
+    int width;
+    int height;
+    std::vector<uint8_t> data;
+
+  public:
+    /**
+     * @brief Construct a new Mask object filled with one value.
+     *
+     * @param width The width of the mask.
+     * @param height The height of the mask.
+     * @param value The initial value of every pixel.
+     */
+    Mask(int width, int height, uint8_t value = 0);
+
+    /**
+     * @brief Construct a new Mask object from the intensity (mean of the three channels) of an image.
+     *
+     * @param image The image to convert.
+     */
+    explicit Mask(const BMPImage& image);
+
+    /**
+     * @brief Construct a new Mask object from a 1-bit, 24-bit or 32-bit BMP file.
+     *
+     * @param filename The name of the BMP file to read.
+     */
+    explicit Mask(const std::filesystem::path& filename);
+
+    /**
+     * @brief Writes the mask to a 24-bit grayscale BMP file.
+     *
+     * @param filename The name of the BMP file to write.
+     */
+    void write(const std::filesystem::path& filename) const;
+
+    int getWidth() const;
+    int getHeight() const;
+
+    /**
+     * @brief Returns a pointer to the first pixel of a row.
+     *
+     * @param y The row index.
+     */
+    uint8_t* row(int y);
+    const uint8_t* row(int y) const;
+
+    /**
+     * @brief Binarizes the mask: values above the level become 255 and the others 0.
+     *
+     * @param level The threshold level.
+     */
+    void threshold(uint8_t level = 128);
+
+    /**
+     * @brief Checks whether every pixel is either 0 or 255.
+     *
+     */
+    bool isBinary() const;
+};
+
+/**
+ * @brief Parses a threshold level given on the command line.
+ *
+ * @param text The level as a decimal integer.
+ * @return The level.
+ * @throws std::invalid_argument If the text is not an integer from 0 to 255.
+ */
+uint8_t parseThresholdLevel(const std::string& text);
+
+#endif  // MASK_H
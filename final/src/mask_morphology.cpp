@@ -0,0 +1,76 @@
+/**
+ * @file mask_morphology.cpp
+ * @author sunfu-chou (sunfu-chou@gmail.com)
+ * @brief Cleans up a segmentation mask with erosion, dilation, opening, closing or hole filling.
+ * @version 0.1
+ * @date 2024-01-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include "bmp.h"
+#include "mask.h"
+#include "morphology.h"
+
+int main(int argc, char* argv[])
+{
+    // Hole filling takes a maximum area instead of the two kernel sizes
+    bool fill_holes = (argc >= 4 && std::string(argv[3]) == "fill-holes");
+    int first_option = fill_holes ? 5 : 6;
+    if (argc != first_option && argc != first_option + 1)
+    {
+        std::cerr << "Usage: " << argv[0] << " <input_file> <output_file> <erode|dilate|open|close> <kernel_width> <kernel_height> [threshold]"
+                  << std::endl;
+        std::cerr << "       " << argv[0] << " <input_file> <output_file> fill-holes <max_area> [threshold]" << std::endl;
+        return 1;
+    }
+
+    const std::map<std::string, MorphologyOperation> operations{ { "erode", MorphologyOperation::Erode },
+                                                                 { "dilate", MorphologyOperation::Dilate },
+                                                                 { "open", MorphologyOperation::Open },
+                                                                 { "close", MorphologyOperation::Close } };
+
+    std::filesystem::path input_filename(argv[1]);
+    std::filesystem::path output_filename(argv[2]);
+    auto operation = operations.find(argv[3]);
+    if (!fill_holes && operation == operations.end())
+    {
+        std::cerr << "Unknown operation: " << argv[3] << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        Mask mask(input_filename);
+        // Binarize first when a threshold is given, which also enables the bit-packed path
+        if (argc == first_option + 1)
+        {
+            mask.threshold(parseThresholdLevel(argv[first_option]));
+        }
+        if (fill_holes)
+        {
+            size_t filled = fillHoles(mask, static_cast<size_t>(std::stoull(argv[4])));
+            std::cout << "Filled " << filled << " holes" << std::endl;
+        }
+        else
+        {
+            applyMorphology(mask, operation->second, std::stoi(argv[4]), std::stoi(argv[5]));
+        }
+        mask.write(output_filename);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << GREEN << "Morphology completed successfully!" << RESET << std::endl;
+    return 0;
+}
@@ -0,0 +1,211 @@
+/**
+ * @file mask_overlay.cpp
+ * @author sunfu-chou (sunfu-chou@gmail.com)
+ * @brief Renders segmentation masks over their images for review: a translucent tint and optional outlines.
+ * Given directories, the images and masks are paired by name and rendered in parallel.
+ * @version 0.1
+ * @date 2024-01-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bmp.h"
+#include "image_io.h"
+#include "mask.h"
+#include "overlay.h"
+
+namespace
+{
+struct Options
+{
+    Pixel color{ 255, 0, 0, 255 };
+    float alpha = 0.5f;
+    int contour = 0;
+    Pixel contour_color{ 0, 255, 255, 255 };
+    std::string image_prefix;
+    std::string mask_prefix;
+    std::string format = ".png";
+};
+
+/**
+ * @brief Parses a color written as RRGGBB into a pixel in BMP channel order.
+ */
+Pixel parseColor(const std::string& text)
+{
+    if (text.size() != 6 || text.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos)
+    {
+        throw std::invalid_argument("Colors are written as RRGGBB: " + text);
+    }
+    unsigned long value = std::stoul(text, nullptr, 16);
+    return Pixel{ static_cast<uint8_t>(value & 0xFF), static_cast<uint8_t>((value >> 8) & 0xFF),
+                  static_cast<uint8_t>((value >> 16) & 0xFF), 255 };
+}
+
+void renderOverlay(const std::filesystem::path& image_filename, const std::filesystem::path& mask_filename,
+                   const std::filesystem::path& output_filename, const Options& options)
+{
+    BMPImage image = readImage(image_filename);
+    Mask mask = readMask(mask_filename);
+    blendMask(image, mask, options.color, options.alpha);
+    if (options.contour > 0)
+    {
+        drawContours(image, mask, options.contour_color, options.contour);
+    }
+    writeImage(image, output_filename);
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4)
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " <image_file|image_dir> <mask_file|mask_dir> <output_file|output_dir> [--color RRGGBB] [--alpha value] "
+                     "[--contour thickness] [--contour-color RRGGBB] [--image-prefix prefix] [--mask-prefix prefix] "
+                     "[--format png|jpg|bmp]"
+                  << std::endl;
+        return 1;
+    }
+
+    std::filesystem::path image_path(argv[1]);
+    std::filesystem::path mask_path(argv[2]);
+    std::filesystem::path output_path(argv[3]);
+    Options options;
+    try
+    {
+        for (int i = 4; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--color" && i + 1 < argc)
+            {
+                options.color = parseColor(argv[++i]);
+            }
+            else if (arg == "--alpha" && i + 1 < argc)
+            {
+                options.alpha = static_cast<float>(std::atof(argv[++i]));
+            }
+            else if (arg == "--contour" && i + 1 < argc)
+            {
+                options.contour = std::atoi(argv[++i]);
+            }
+            else if (arg == "--contour-color" && i + 1 < argc)
+            {
+                options.contour_color = parseColor(argv[++i]);
+            }
+            else if (arg == "--image-prefix" && i + 1 < argc)
+            {
+                options.image_prefix = argv[++i];
+            }
+            else if (arg == "--mask-prefix" && i + 1 < argc)
+            {
+                options.mask_prefix = argv[++i];
+            }
+            else if (arg == "--format" && i + 1 < argc)
+            {
+                options.format = std::string(".") + argv[++i];
+            }
+            else
+            {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    // One job per image: the image, its mask and the output file
+    struct Job
+    {
+        std::filesystem::path image;
+        std::filesystem::path mask;
+        std::filesystem::path output;
+        std::string error;
+    };
+    std::vector<Job> jobs;
+    try
+    {
+        if (std::filesystem::is_directory(image_path))
+        {
+            auto images = listImages(image_path, options.image_prefix);
+            auto masks = listImages(mask_path, options.mask_prefix);
+            std::filesystem::create_directories(output_path);
+            for (const auto& [key, image] : images)
+            {
+                auto mask = masks.find(key);
+                if (mask == masks.end())
+                {
+                    std::cerr << YELLOW << "No mask for " << image << RESET << std::endl;
+                    continue;
+                }
+                std::filesystem::path output = output_path / image.filename();
+                jobs.push_back(Job{ image, mask->second, output.replace_extension(options.format), {} });
+            }
+        }
+        else
+        {
+            jobs.push_back(Job{ image_path, mask_path, output_path, {} });
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::atomic<size_t> next{ 0 };
+    auto worker = [&]() {
+        for (size_t i = next++; i < jobs.size(); i = next++)
+        {
+            try
+            {
+                renderOverlay(jobs[i].image, jobs[i].mask, jobs[i].output, options);
+            }
+            catch (const std::exception& e)
+            {
+                jobs[i].error = e.what();
+            }
+        }
+    };
+    size_t thread_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), jobs.size());
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < thread_count; ++t)
+    {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers)
+    {
+        thread.join();
+    }
+
+    int failed = 0;
+    for (const Job& job : jobs)
+    {
+        if (!job.error.empty())
+        {
+            std::cerr << RED << "Error: " << job.image << ": " << job.error << RESET << std::endl;
+            ++failed;
+        }
+    }
+    if (failed > 0)
+    {
+        std::cerr << RED << failed << " of " << jobs.size() << " overlays failed" << RESET << std::endl;
+        return 1;
+    }
+    std::cout << GREEN << "Rendered " << jobs.size() << " overlays successfully!" << RESET << std::endl;
+    return 0;
+}
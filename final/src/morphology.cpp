@@ -0,0 +1,452 @@
+/**
+ * @file morphology.cpp
+ * @author sunfu-chou (sunfu-chou@gmail.com)
+ * @brief This file contains the implementation of the morphological operations on masks.
+ * @version 0.1
+ * @date 2024-01-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "morphology.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "binary_mask.h"
+#include "components.h"
+#include "mask.h"
+
+namespace
+{
+/**
+ * @brief Minimum of bytes: erosion of grayscale masks.
+ */
+struct MinBytes
+{
+    using Type = uint8_t;
+    static constexpr uint8_t identity = 255;
+
+    static uint8_t apply(uint8_t a, uint8_t b)
+    {
+        return std::min(a, b);
+    }
+
+    static void apply(uint8_t* out, const uint8_t* a, const uint8_t* b, size_t count)
+    {
+        size_t i = 0;
+#ifdef __SSE2__
+        for (; i + 16 <= count; i += 16)
+        {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_min_epu8(va, vb));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            out[i] = std::min(a[i], b[i]);
+        }
+    }
+};
+
+/**
+ * @brief Maximum of bytes: dilation of grayscale masks.
+ */
+struct MaxBytes
+{
+    using Type = uint8_t;
+    static constexpr uint8_t identity = 0;
+
+    static uint8_t apply(uint8_t a, uint8_t b)
+    {
+        return std::max(a, b);
+    }
+
+    static void apply(uint8_t* out, const uint8_t* a, const uint8_t* b, size_t count)
+    {
+        size_t i = 0;
+#ifdef __SSE2__
+        for (; i + 16 <= count; i += 16)
+        {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_max_epu8(va, vb));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            out[i] = std::max(a[i], b[i]);
+        }
+    }
+};
+
+/**
+ * @brief Bitwise AND of packed words: erosion of binary masks.
+ */
+struct AndWords
+{
+    using Type = uint64_t;
+    static constexpr uint64_t identity = ~uint64_t{ 0 };
+
+    static void apply(uint64_t* out, const uint64_t* a, const uint64_t* b, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            out[i] = a[i] & b[i];
+        }
+    }
+};
+
+/**
+ * @brief Bitwise OR of packed words: dilation of binary masks.
+ */
+struct OrWords
+{
+    using Type = uint64_t;
+    static constexpr uint64_t identity = 0;
+
+    static void apply(uint64_t* out, const uint64_t* a, const uint64_t* b, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            out[i] = a[i] | b[i];
+        }
+    }
+};
+
+/**
+ * @brief Van Herk / Gil-Werman filter along the rows of a plane: every row becomes the operation over the rows
+ * [y - length / 2, y - length / 2 + length). The padded sequence of rows is cut into blocks of the window
+ * length; with running results from the start (prefix) and to the end (suffix) of each block, any window is
+ * one suffix combined with one prefix, so each row costs three row operations whatever the length.
+ */
+template <typename Op>
+void vanHerkColumns(typename Op::Type* plane, size_t row_length, int rows, int length)
+{
+    using T = typename Op::Type;
+    int anchor = length / 2;
+    int blocks = (rows + 2 * length - 2) / length;
+    size_t padded_rows = static_cast<size_t>(blocks) * length;
+
+    std::vector<T> identity(row_length, Op::identity);
+    auto source = [&](int i) -> const T* {
+        int y = i - anchor;
+        return (y >= 0 && y < rows) ? plane + static_cast<size_t>(y) * row_length : identity.data();
+    };
+
+    std::vector<T> prefix(padded_rows * row_length), suffix(padded_rows * row_length);
+    for (int block = 0; block < blocks; ++block)
+    {
+        int first = block * length;
+        int last = first + length - 1;
+        std::copy_n(source(first), row_length, &prefix[first * row_length]);
+        for (int i = first + 1; i <= last; ++i)
+        {
+            Op::apply(&prefix[i * row_length], &prefix[(i - 1) * row_length], source(i), row_length);
+        }
+        std::copy_n(source(last), row_length, &suffix[last * row_length]);
+        for (int i = last - 1; i >= first; --i)
+        {
+            Op::apply(&suffix[i * row_length], &suffix[(i + 1) * row_length], source(i), row_length);
+        }
+    }
+
+    for (int y = 0; y < rows; ++y)
+    {
+        Op::apply(plane + static_cast<size_t>(y) * row_length, &suffix[y * row_length], &prefix[(y + length - 1) * row_length], row_length);
+    }
+}
+
+/**
+ * @brief Van Herk / Gil-Werman filter along one row of bytes (see vanHerkColumns).
+ */
+template <typename Op>
+void vanHerkRow(uint8_t* row, int width, int length, std::vector<uint8_t>& prefix, std::vector<uint8_t>& suffix)
+{
+    int anchor = length / 2;
+    int blocks = (width + 2 * length - 2) / length;
+    size_t padded = static_cast<size_t>(blocks) * length;
+    prefix.resize(padded);
+    suffix.resize(padded);
+    auto source = [&](int i) {
+        int x = i - anchor;
+        return (x >= 0 && x < width) ? row[x] : Op::identity;
+    };
+
+    for (int block = 0; block < blocks; ++block)
+    {
+        int first = block * length;
+        int last = first + length - 1;
+        prefix[first] = source(first);
+        for (int i = first + 1; i <= last; ++i)
+        {
+            prefix[i] = Op::apply(prefix[i - 1], source(i));
+        }
+        suffix[last] = source(last);
+        for (int i = last - 1; i >= first; --i)
+        {
+            suffix[i] = Op::apply(suffix[i + 1], source(i));
+        }
+    }
+
+    for (int x = 0; x < width; ++x)
+    {
+        row[x] = Op::apply(suffix[x], prefix[x + length - 1]);
+    }
+}
+
+/**
+ * @brief Shifts a packed row towards lower x: bit x of out is bit x + shift of in, with identity bits past the end.
+ */
+template <typename Op>
+void shiftToLower(const uint64_t* in, uint64_t* out, size_t words, int shift)
+{
+    size_t word_shift = shift / 64;
+    int bit_shift = shift % 64;
+    for (size_t w = 0; w < words; ++w)
+    {
+        uint64_t low = (w + word_shift < words) ? in[w + word_shift] : Op::identity;
+        uint64_t high = (w + word_shift + 1 < words) ? in[w + word_shift + 1] : Op::identity;
+        out[w] = (bit_shift == 0) ? low : (low >> bit_shift) | (high << (64 - bit_shift));
+    }
+}
+
+/**
+ * @brief Shifts a packed row towards higher x: bit x of out is bit x - shift of in, with identity bits before the start.
+ */
+template <typename Op>
+void shiftToHigher(const uint64_t* in, uint64_t* out, size_t words, int shift)
+{
+    size_t word_shift = shift / 64;
+    int bit_shift = shift % 64;
+    for (size_t w = 0; w < words; ++w)
+    {
+        uint64_t high = (w >= word_shift) ? in[w - word_shift] : Op::identity;
+        uint64_t low = (w >= word_shift + 1) ? in[w - word_shift - 1] : Op::identity;
+        out[w] = (bit_shift == 0) ? high : (high << bit_shift) | (low >> (64 - bit_shift));
+    }
+}
+
+/**
+ * @brief Extends a run of covered bits to length bits by doubling.
+ * Combining a run with itself shifted by its length doubles it, so only log2(length) shifted passes
+ * are needed. Forward runs cover [x, x + length), backward runs cover (x - length, x].
+ */
+template <typename Op, bool Forward>
+void extendRun(uint64_t* row, size_t words, int length, std::vector<uint64_t>& scratch)
+{
+    int covered = 1;
+    while (covered < length)
+    {
+        int step = std::min(covered, length - covered);
+        Forward ? shiftToLower<Op>(row, scratch.data(), words, step) : shiftToHigher<Op>(row, scratch.data(), words, step);
+        Op::apply(row, row, scratch.data(), words);
+        covered += step;
+    }
+}
+
+/**
+ * @brief Applies the operation over the window [x - length / 2, x - length / 2 + length) along a packed row.
+ * The window is split at x into a backward and a forward run, so the identity bits shifted in at
+ * either end only ever stand for pixels outside the row.
+ */
+template <typename Op>
+void runRow(uint64_t* row, size_t words, int length, std::vector<uint64_t>& scratch, std::vector<uint64_t>& backward)
+{
+    scratch.resize(words);
+    backward.assign(row, row + words);
+    int anchor = length / 2;
+    extendRun<Op, true>(row, words, length - anchor, scratch);
+    extendRun<Op, false>(backward.data(), words, anchor + 1, scratch);
+    Op::apply(row, row, backward.data(), words);
+}
+
+/**
+ * @brief Erodes or dilates a mask of bytes.
+ */
+template <typename Op>
+void grayMorphology(Mask& mask, int kernel_width, int kernel_height)
+{
+    int width = mask.getWidth();
+    int height = mask.getHeight();
+    if (kernel_width > 1)
+    {
+        std::vector<uint8_t> prefix, suffix;
+        for (int y = 0; y < height; ++y)
+        {
+            vanHerkRow<Op>(mask.row(y), width, kernel_width, prefix, suffix);
+        }
+    }
+    if (kernel_height > 1)
+    {
+        vanHerkColumns<Op>(mask.row(0), width, height, kernel_height);
+    }
+}
+
+/**
+ * @brief Erodes or dilates a bit-packed mask.
+ */
+template <typename Op>
+void binaryMorphology(BinaryMask& mask, int kernel_width, int kernel_height)
+{
+    int width = mask.getWidth();
+    int height = mask.getHeight();
+    size_t words = mask.getWordsPerRow();
+
+    // The bits past the width hold the identity while filtering so that they never affect a window
+    if (width % 64 != 0)
+    {
+        uint64_t padding = ~uint64_t{ 0 } << (width % 64);
+        for (int y = 0; y < height; ++y)
+        {
+            mask.row(y)[words - 1] |= Op::identity & padding;
+        }
+    }
+
+    if (kernel_width > 1)
+    {
+        std::vector<uint64_t> scratch, backward;
+        for (int y = 0; y < height; ++y)
+        {
+            runRow<Op>(mask.row(y), words, kernel_width, scratch, backward);
+        }
+    }
+    if (kernel_height > 1)
+    {
+        vanHerkColumns<Op>(mask.row(0), words, height, kernel_height);
+    }
+    mask.clearPadding();
+}
+
+/**
+ * @brief Runs an operation as a sequence of erosions and dilations.
+ */
+template <typename Erode, typename Dilate>
+void runOperation(MorphologyOperation operation, Erode erode_mask, Dilate dilate_mask)
+{
+    switch (operation)
+    {
+        case MorphologyOperation::Erode:
+            erode_mask();
+            break;
+        case MorphologyOperation::Dilate:
+            dilate_mask();
+            break;
+        case MorphologyOperation::Open:
+            erode_mask();
+            dilate_mask();
+            break;
+        case MorphologyOperation::Close:
+            dilate_mask();
+            erode_mask();
+            break;
+    }
+}
+
+void checkKernel(int kernel_width, int kernel_height)
+{
+    if (kernel_width < 1 || kernel_height < 1)
+    {
+        throw std::invalid_argument("Structuring element size must be positive");
+    }
+}
+}  // namespace
+
+void applyMorphology(Mask& mask, MorphologyOperation operation, int kernel_width, int kernel_height)
+{
+    checkKernel(kernel_width, kernel_height);
+    if (mask.isBinary())
+    {
+        BinaryMask packed(mask);
+        applyMorphology(packed, operation, kernel_width, kernel_height);
+        mask = packed.toMask();
+        return;
+    }
+    runOperation(
+        operation, [&]() { grayMorphology<MinBytes>(mask, kernel_width, kernel_height); },
+        [&]() { grayMorphology<MaxBytes>(mask, kernel_width, kernel_height); });
+}
+
+void applyMorphology(BinaryMask& mask, MorphologyOperation operation, int kernel_width, int kernel_height)
+{
+    checkKernel(kernel_width, kernel_height);
+    runOperation(
+        operation, [&]() { binaryMorphology<AndWords>(mask, kernel_width, kernel_height); },
+        [&]() { binaryMorphology<OrWords>(mask, kernel_width, kernel_height); });
+}
+
+void erode(Mask& mask, int kernel_width, int kernel_height)
+{
+    applyMorphology(mask, MorphologyOperation::Erode, kernel_width, kernel_height);
+}
+
+void dilate(Mask& mask, int kernel_width, int kernel_height)
+{
+    applyMorphology(mask, MorphologyOperation::Dilate, kernel_width, kernel_height);
+}
+
+void opening(Mask& mask, int kernel_width, int kernel_height)
+{
+    applyMorphology(mask, MorphologyOperation::Open, kernel_width, kernel_height);
+}
+
+void closing(Mask& mask, int kernel_width, int kernel_height)
+{
+    applyMorphology(mask, MorphologyOperation::Close, kernel_width, kernel_height);
+}
+
+size_t fillHoles(Mask& mask, size_t max_area)
+{
+    int width = mask.getWidth();
+    int height = mask.getHeight();
+    Mask background(width, height);
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t* in = mask.row(y);
+        uint8_t* out = background.row(y);
+        for (int x = 0; x < width; ++x)
+        {
+            out[x] = (in[x] == 0) ? 255 : 0;
+        }
+    }
+
+    std::vector<int32_t> labels;
+    std::vector<Component> regions = labelComponents(background, labels, Connectivity::Four);
+    // Indexed by label; the regions that reach the border are the outside, not holes
+    std::vector<uint8_t> fill(regions.size() + 1, 0);
+    size_t filled = 0;
+    for (const Component& region : regions)
+    {
+        bool enclosed = region.min_x > 0 && region.min_y > 0 && region.max_x < width - 1 && region.max_y < height - 1;
+        if (enclosed && region.area <= max_area)
+        {
+            fill[region.label] = 1;
+            ++filled;
+        }
+    }
+    if (filled == 0)
+    {
+        return 0;
+    }
+
+    for (int y = 0; y < height; ++y)
+    {
+        const int32_t* label = &labels[static_cast<size_t>(y) * width];
+        uint8_t* row = mask.row(y);
+        for (int x = 0; x < width; ++x)
+        {
+            if (fill[label[x]])
+            {
+                row[x] = 255;
+            }
+        }
+    }
+    return filled;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file morphology.h
+ * @author sunfu-chou (sunfu-chou@gmail.com)
+ * @brief This file contains the declarations of the morphological operations on masks.
+ * Every operation uses a rectangular structuring element and costs O(1) per pixel regardless of its size
+ * (van Herk / Gil-Werman). Binary masks are processed bit-packed, 64 pixels per word.
+ * @version 0.1
+ * @date 2024-01-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef MORPHOLOGY_H
+#define MORPHOLOGY_H
+
+#include <stddef.h>
+
+#include "binary_mask.h"
+#include "mask.h"
+
+/**
+ * @brief The MorphologyOperation enum selects a morphological operation.
+ * - Erode: the minimum over the structuring element
+ * - Dilate: the maximum over the structuring element
+ * - Open: erosion followed by dilation, which removes foreground specks smaller than the element
+ * - Close: dilation followed by erosion, which fills background holes and gaps smaller than the element
+ *
+ */
+enum class MorphologyOperation
+{
+    Erode,
+    Dilate,
+    Open,
+    Close
+};
+
+/**
+ * @brief Applies a morphological operation with a kernel_width x kernel_height rectangle.
+ * The rectangle is anchored at (kernel_width / 2, kernel_height / 2), and pixels outside the mask are
+ * ignored. Masks that only hold 0 and 255 take the bit-packed path; any other mask is processed per byte.
+ *
+ * @param mask The mask to process in place.
+ * @param operation The operation to apply.
+ * @param kernel_width The width of the structuring element (at least 1).
+ * @param kernel_height The height of the structuring element (at least 1).
+ */
+void applyMorphology(Mask& mask, MorphologyOperation operation, int kernel_width, int kernel_height);
+
+/**
+ * @brief Applies a morphological operation to a bit-packed mask, 64 pixels per word operation.
+ *
+ * @param mask The mask to process in place.
+ * @param operation The operation to apply.
+ * @param kernel_width The width of the structuring element (at least 1).
+ * @param kernel_height The height of the structuring element (at least 1).
+ */
+void applyMorphology(BinaryMask& mask, MorphologyOperation operation, int kernel_width, int kernel_height);
+
+/**
+ * @brief Erodes the mask with a kernel_width x kernel_height rectangle.
+ *
+ */
+void erode(Mask& mask, int kernel_width, int kernel_height);
+
+/**
+ * @brief Dilates the mask with a kernel_width x kernel_height rectangle.
+ *
+ */
+void dilate(Mask& mask, int kernel_width, int kernel_height);
+
+/**
+ * @brief Opens the mask (erosion, then dilation) with a kernel_width x kernel_height rectangle.
+ *
+ */
+void opening(Mask& mask, int kernel_width, int kernel_height);
+
+/**
+ * @brief Closes the mask (dilation, then erosion) with a kernel_width x kernel_height rectangle.
+ *
+ */
+void closing(Mask& mask, int kernel_width, int kernel_height);
+
+/**
+ * @brief Fills the holes of a mask up to a maximum area.
+ * A hole is a 4-connected region of zero pixels that does not touch the border of the mask, the dual of the
+ * 8-connected foreground of findComponents. The holes are found by labeling the inverted mask with
+ * labelComponents, and unlike a closing they are filled whatever their shape.
+ *
+ * @param mask The mask to fill in place; the filled pixels become 255.
+ * @param max_area The largest area of a hole that is filled.
+ * @return The number of holes filled.
+ */
+size_t fillHoles(Mask& mask, size_t max_area);
+
+#endif  // MORPHOLOGY_H
@@ -0,0 +1,157 @@
+/**
+ * @file overlay.cpp
+ * @author sunfu-chou (sunfu-chou@gmail.com)
+ * @brief This file contains the implementation of the mask overlays.
+ * @version 0.1
+ * @date 2024-01-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "overlay.h"
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "binary_mask.h"
+#include "morphology.h"
+
+namespace
+{
+void checkSameSize(const BMPImage& image, const Mask& mask)
+{
+    if (image.getWidth() != mask.getWidth() || image.getHeight() != mask.getHeight())
+    {
+        throw std::invalid_argument("Mask size does not match the image");
+    }
+}
+
+/**
+ * @brief Blends one channel: (pixel * (255 - weight) + color * weight) / 255, rounded.
+ * The sum stays below 65536, and the division by 255 is (t + (t >> 8)) >> 8 with t = sum + 128, which is exact
+ * for every sum in range.
+ */
+inline uint8_t blendChannel(int pixel, int color, int weight)
+{
+    int t = pixel * (255 - weight) + color * weight + 128;
+    return static_cast<uint8_t>((t + (t >> 8)) >> 8);
+}
+}  // namespace
+
+void blendMask(BMPImage& image, const Mask& mask, const Pixel& color, float alpha)
+{
+    checkSameSize(image, mask);
+    if (!(alpha >= 0.0f && alpha <= 1.0f))
+    {
+        throw std::invalid_argument("Alpha must be in [0, 1]");
+    }
+
+    // The weight of the tint for every mask value, on a 0 to 255 scale
+    std::array<uint16_t, 256> weights;
+    for (int value = 0; value < 256; ++value)
+    {
+        weights[value] = static_cast<uint16_t>(std::lround(alpha * value));
+    }
+
+    int width = image.getWidth();
+    for (int y = 0; y < image.getHeight(); ++y)
+    {
+        const uint8_t* coverage = mask.row(y);
+        Pixel* pixels = image.row(y);
+        int x = 0;
+#ifdef __SSE2__
+        // Two pixels per 16-bit half: lanes 0-3 and 4-7 hold their four channels, and the alpha lanes get no weight
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i max_weight = _mm_set1_epi16(255);
+        const __m128i rounding = _mm_set1_epi16(128);
+        const __m128i tint = _mm_set_epi16(0, color.b, color.g, color.r, 0, color.b, color.g, color.r);
+        for (; x + 4 <= width; x += 4)
+        {
+            uint32_t block;
+            std::memcpy(&block, coverage + x, sizeof(block));
+            if (block == 0)
+            {
+                continue;
+            }
+            uint16_t w0 = weights[coverage[x]], w1 = weights[coverage[x + 1]];
+            uint16_t w2 = weights[coverage[x + 2]], w3 = weights[coverage[x + 3]];
+            __m128i weight_low = _mm_set_epi16(0, w1, w1, w1, 0, w0, w0, w0);
+            __m128i weight_high = _mm_set_epi16(0, w3, w3, w3, 0, w2, w2, w2);
+
+            __m128i source = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + x));
+            auto blend = [&](__m128i channels, __m128i weight) {
+                __m128i sum = _mm_add_epi16(_mm_mullo_epi16(channels, _mm_sub_epi16(max_weight, weight)),
+                                            _mm_mullo_epi16(tint, weight));
+                sum = _mm_add_epi16(sum, rounding);
+                return _mm_srli_epi16(_mm_add_epi16(sum, _mm_srli_epi16(sum, 8)), 8);
+            };
+            __m128i low = blend(_mm_unpacklo_epi8(source, zero), weight_low);
+            __m128i high = blend(_mm_unpackhi_epi8(source, zero), weight_high);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + x), _mm_packus_epi16(low, high));
+        }
+#endif
+        for (; x < width; ++x)
+        {
+            int weight = weights[coverage[x]];
+            if (weight == 0)
+            {
+                continue;
+            }
+            Pixel& pixel = pixels[x];
+            pixel.r = blendChannel(pixel.r, color.r, weight);
+            pixel.g = blendChannel(pixel.g, color.g, weight);
+            pixel.b = blendChannel(pixel.b, color.b, weight);
+        }
+    }
+}
+
+void drawContours(BMPImage& image, const Mask& mask, const Pixel& color, int thickness)
+{
+    checkSameSize(image, mask);
+    if (thickness < 1)
+    {
+        throw std::invalid_argument("Contour thickness must be positive");
+    }
+
+    BinaryMask regions(mask.getWidth(), mask.getHeight());
+    for (int y = 0; y < mask.getHeight(); ++y)
+    {
+        regions.packRow(y, mask.row(y), 127);
+    }
+    // Outline = regions AND NOT eroded regions
+    BinaryMask outline = regions;
+    applyMorphology(outline, MorphologyOperation::Erode, 2 * thickness + 1, 2 * thickness + 1);
+    outline.invert();
+    outline &= regions;
+
+    for (int y = 0; y < outline.getHeight(); ++y)
+    {
+        const uint64_t* words = outline.row(y);
+        Pixel* pixels = image.row(y);
+        for (size_t w = 0; w < outline.getWordsPerRow(); ++w)
+        {
+            if (words[w] == 0)
+            {
+                continue;
+            }
+            for (int bit = 0; bit < 64; ++bit)
+            {
+                if (((words[w] >> bit) & 1) == 0)
+                {
+                    continue;
+                }
+                Pixel& pixel = pixels[w * 64 + bit];
+                pixel.r = color.r;
+                pixel.g = color.g;
+                pixel.b = color.b;
+            }
+        }
+    }
+}
@@ -0,0 +1,42 @@
+/**
+ * @file overlay.h
+ * @author sunfu-chou (sunfu-chou@gmail.com)
+ * @brief This file contains the declarations of the mask overlays drawn on images for review.
+ * @version 0.1
+ * @date 2024-01-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include "bmp.h"
+#include "mask.h"
+
+/**
+ * @brief Tints the image with a color where the mask is set.
+ * Every pixel becomes pixel + (color - pixel) * alpha * mask / 255 in 8-bit fixed point, so soft masks fade the
+ * tint out; the alpha channel of the image is kept. Runs of background pixels are skipped.
+ *
+ * @param image The image to tint in place.
+ * @param mask The mask, of the same size as the image.
+ * @param color The tint, in the channel order of the image pixels (Pixel{ blue, green, red } for BMP images).
+ * @param alpha The opacity of the tint in [0, 1].
+ */
+void blendMask(BMPImage& image, const Mask& mask, const Pixel& color, float alpha);
+
+/**
+ * @brief Draws the outline of the mask regions (pixels above 127) on the image.
+ * The outline is the part of each region that an erosion with a (2 * thickness + 1) square removes, so it lies
+ * inside the regions and is not drawn along the image border.
+ *
+ * @param image The image to draw on in place.
+ * @param mask The mask, of the same size as the image.
+ * @param color The outline color, in the channel order of the image pixels.
+ * @param thickness The outline thickness in pixels (at least 1).
+ */
+void drawContours(BMPImage& image, const Mask& mask, const Pixel& color, int thickness = 1);
+
+#endif  // OVERLAY_H
@@ -13,11 +13,17 @@
  */
 #include "bmp.h"
 #include <algorithm>
+#include <array>
 #include <fstream>
 #include <iomanip>
 #include <filesystem>
 #include <stdexcept>
 #include <iostream>
+#include <unordered_map>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 BMPImage::BMPImage(const std::string& filename)
 {
@@ -70,14 +76,14 @@ void BMPImage::read(const std::string& filename)
     file.close();
 }
 
-void BMPImage::write(const std::string& filename)
+void BMPImage::createParentDirectory(const std::string& filename)
 {
 #ifdef __cplusplus
 #if __cplusplus >= 201703L  // Check for C++17 or later
     std::filesystem::path filePath(filename);
     std::string folderName = filePath.parent_path().string();
-    // Check if the directory exists, and if not, create it
-    if (!std::filesystem::exists(folderName))
+    // Check if the directory exists, and if not, create it; a bare file name lives in the current directory
+    if (!folderName.empty() && !std::filesystem::exists(folderName))
     {
         if (!std::filesystem::create_directory(folderName))
         {
@@ -86,6 +92,11 @@ void BMPImage::write(const std::string& filename)
     }
 #endif
 #endif
+}
+
+void BMPImage::write(const std::string& filename)
+{
+    createParentDirectory(filename);
 
     std::ofstream file(filename, std::ios::binary);
     if (!file)
@@ -115,20 +126,257 @@ void BMPImage::write(const std::string& filename)
     file.close();
 }
 
+void BMPImage::writePalettized(const std::string& filename) const
+{
+    // Collect the distinct colors, keyed by their packed channel bytes
+    std::vector<uint32_t> palette;
+    std::unordered_map<uint32_t, uint8_t> color_index;
+    std::vector<std::vector<uint8_t>> indices(info_header.height, std::vector<uint8_t>(info_header.width));
+
+    for (int y = 0; y < info_header.height; y++)
+    {
+        for (int x = 0; x < info_header.width; x++)
+        {
+            const Pixel& pixel = pixels[y][x];
+            uint32_t key = pixel.r | (pixel.g << 8) | (pixel.b << 16);
+            auto it = color_index.find(key);
+            if (it == color_index.end())
+            {
+                if (palette.size() == 256)
+                {
+                    throw std::runtime_error("Too many colors for a palettized BMP (more than 256).");
+                }
+                it = color_index.emplace(key, static_cast<uint8_t>(palette.size())).first;
+                palette.push_back(key);
+            }
+            indices[y][x] = it->second;
+        }
+    }
+
+    // Use the smallest supported index width
+    int bits = 1;
+    while ((1u << bits) < palette.size())
+    {
+        bits *= 2;
+    }
+
+    int row_size = (info_header.width * bits + 31) / 32 * 4;
+    uint32_t palette_size = palette.size() * 4;
+
+    BMPFileHeader file_header = header;
+    BMPInfoHeader palette_info_header = info_header;
+    palette_info_header.size = sizeof(BMPInfoHeader);
+    palette_info_header.bit_count = bits;
+    palette_info_header.compression = 0;
+    palette_info_header.image_size = row_size * info_header.height;
+    palette_info_header.used_colors = palette.size();
+    palette_info_header.important_colors = 0;
+    file_header.offset = sizeof(BMPFileHeader) + sizeof(BMPInfoHeader) + palette_size;
+    file_header.size = file_header.offset + palette_info_header.image_size;
+
+    createParentDirectory(filename);
+    std::ofstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("Unable to open file");
+    }
+
+    file.write(reinterpret_cast<const char*>(&file_header), sizeof(file_header));
+    file.write(reinterpret_cast<const char*>(&palette_info_header), sizeof(palette_info_header));
+
+    // Palette entries are stored in the same byte order as the pixels, followed by a reserved byte
+    for (uint32_t color : palette)
+    {
+        const uint8_t entry[4] = { static_cast<uint8_t>(color), static_cast<uint8_t>(color >> 8), static_cast<uint8_t>(color >> 16), 0 };
+        file.write(reinterpret_cast<const char*>(entry), sizeof(entry));
+    }
+
+    // Pack the indices, most significant bits first
+    int pixels_per_byte = 8 / bits;
+    std::vector<uint8_t> packed(row_size);
+    for (int y = 0; y < info_header.height; y++)
+    {
+        std::fill(packed.begin(), packed.end(), 0);
+        for (int x = 0; x < info_header.width; x++)
+        {
+            int shift = 8 - bits * (x % pixels_per_byte + 1);
+            packed[x / pixels_per_byte] |= indices[y][x] << shift;
+        }
+        file.write(reinterpret_cast<const char*>(packed.data()), row_size);
+    }
+
+    file.close();
+}
+
+namespace
+{
+// Side length of the blocks the transpose recursion stops at; 16x16 pixels (1 KiB) fit comfortably in L1.
+constexpr int TRANSPOSE_BLOCK = 16;
+
+/**
+ * @brief Cache-oblivious transpose of src[y0, y1) x [x0, x1) into dst.
+ * The longer side is halved until the block is small enough to stay in cache for both reads and writes.
+ */
+void transposeBlock(const std::vector<std::vector<Pixel>>& src, std::vector<std::vector<Pixel>>& dst, int y0, int y1, int x0, int x1)
+{
+    int h = y1 - y0;
+    int w = x1 - x0;
+    if (h <= TRANSPOSE_BLOCK && w <= TRANSPOSE_BLOCK)
+    {
+        for (int x = x0; x < x1; x++)
+        {
+            Pixel* out = dst[x].data();
+            for (int y = y0; y < y1; y++)
+            {
+                out[y] = src[y][x];
+            }
+        }
+    }
+    else if (h >= w)
+    {
+        int ym = y0 + h / 2;
+        transposeBlock(src, dst, y0, ym, x0, x1);
+        transposeBlock(src, dst, ym, y1, x0, x1);
+    }
+    else
+    {
+        int xm = x0 + w / 2;
+        transposeBlock(src, dst, y0, y1, x0, xm);
+        transposeBlock(src, dst, y0, y1, xm, x1);
+    }
+}
+
+/**
+ * @brief Reverses a row of pixels in place.
+ */
+void reverseRow(std::vector<Pixel>& row)
+{
+    Pixel* left = row.data();
+    Pixel* right = row.data() + row.size();
+
+#ifdef __SSE2__
+    static_assert(sizeof(Pixel) == 4, "Pixel must be 32 bits wide");
+    // Swap four pixels from each end per step, reversing their order within the register.
+    while (right - left >= 8)
+    {
+        right -= 4;
+        __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left));
+        __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(right));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(left), _mm_shuffle_epi32(r, _MM_SHUFFLE(0, 1, 2, 3)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(right), _mm_shuffle_epi32(l, _MM_SHUFFLE(0, 1, 2, 3)));
+        left += 4;
+    }
+#endif
+
+    std::reverse(left, right);
+}
+}  // namespace
+
 void BMPImage::flipHorizontal()
 {
     for (int i = 0; i < info_header.height; i++)
     {
-        std::reverse(pixels[i].begin(), pixels[i].end());
+        reverseRow(pixels[i]);
     }
 }
 
-void BMPImage::quantize(const int bit_depth)
+void BMPImage::flipVertical()
+{
+    // Swapping vectors only exchanges their buffers
+    std::reverse(pixels.begin(), pixels.end());
+}
+
+void BMPImage::transposePixels()
+{
+    int width = info_header.width;
+    int height = info_header.height;
+
+    std::vector<std::vector<Pixel>> new_pixels(width, std::vector<Pixel>(height));
+    transposeBlock(pixels, new_pixels, 0, height, 0, width);
+
+    pixels.swap(new_pixels);
+    info_header.width = height;
+    info_header.height = width;
+    updateImageSize();
+}
+
+void BMPImage::transpose()
+{
+    // The stored rows are bottom-up, so the on-screen main diagonal is the stored anti-diagonal.
+    flipVertical();
+    transposePixels();
+    flipVertical();
+}
+
+void BMPImage::rotate90(const bool clockwise)
+{
+    transposePixels();
+    if (clockwise)
+    {
+        flipVertical();
+    }
+    else
+    {
+        flipHorizontal();
+    }
+}
+
+void BMPImage::rotate180()
+{
+    flipVertical();
+    flipHorizontal();
+}
+
+void BMPImage::normalizeOrientation(const int orientation)
+{
+    switch (orientation)
+    {
+        case 1:
+            break;
+        case 2:
+            flipHorizontal();
+            break;
+        case 3:
+            rotate180();
+            break;
+        case 4:
+            flipVertical();
+            break;
+        case 5:
+            transpose();
+            break;
+        case 6:
+            rotate90(true);
+            break;
+        case 7:
+            // Transverse: mirror over the on-screen anti-diagonal, which is the stored main diagonal
+            transposePixels();
+            break;
+        case 8:
+            rotate90(false);
+            break;
+        default:
+            throw std::runtime_error("Invalid EXIF orientation. Must be between 1 and 8.");
+    }
+}
+
+void BMPImage::updateImageSize()
+{
+    int row_size = (info_header.width * info_header.bit_count + 31) / 32 * 4;
+    info_header.image_size = row_size * info_header.height;
+    header.size = header.offset + info_header.image_size;
+}
+
+void BMPImage::quantize(const int bit_depth, const Dither dither)
 {
     if (bit_depth <= 0 || bit_depth > 8)
     {
         throw std::runtime_error("Invalid bit depth for quantization.");
     }
+    if (dither != Dither::None && bit_depth == 8)
+    {
+        throw std::runtime_error("Dithering requires a bit depth below 8.");
+    }
 
     // Compute the factor to scale down and then scale up the pixel value.
     int scale_down_factor = (1 << (8 - bit_depth));
@@ -138,17 +386,129 @@ void BMPImage::quantize(const int bit_depth)
     std::cout << "scale_down_factor: " << scale_down_factor << std::endl;
     std::cout << "scale_up_factor: " << scale_up_factor << std::endl;
 
-    for (int y = 0; y < info_header.height; y++)
+    // The output levels are k * scale_up_factor for k in [0, 2^bit_depth). Without dithering a value keeps the level
+    // of its top bits, as it always has; the dithering modes map a value to its nearest level instead, so a flat region
+    // averages to its own value.
+    int max_level = (1 << bit_depth) - 1;
+    int max_value = max_level * scale_up_factor;
+    bool has_alpha = (info_header.bit_count == 32);
+
+    // Map a value to its nearest level, given as a value already offset by a threshold or an error.
+    int divisor = std::max(scale_up_factor, 1);
+    auto nearest_level = [&](int value) {
+        int level = (std::max(value, 0) + scale_up_factor / 2) / divisor;
+        return static_cast<uint8_t>(std::min(level, max_level) * scale_up_factor);
+    };
+
+    if (dither == Dither::None)
     {
-        for (int x = 0; x < info_header.width; x++)
+        for (auto& row : pixels)
+        {
+            uint8_t* channel = reinterpret_cast<uint8_t*>(row.data());
+            size_t count = row.size() * sizeof(Pixel);
+            size_t i = 0;
+#ifdef __SSE2__
+            // Sixteen channels per step in 16-bit lanes: shift the top bits down and scale them back up.
+            // The alpha lanes are restored afterwards when the image has no alpha channel.
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i shift = _mm_cvtsi32_si128(8 - bit_depth);
+            const __m128i factor = _mm_set1_epi16(static_cast<int16_t>(scale_up_factor));
+            const __m128i alpha_mask = _mm_set1_epi32(has_alpha ? 0 : static_cast<int>(0xFF000000));
+            auto quantize_lanes = [&](__m128i lanes) { return _mm_mullo_epi16(_mm_srl_epi16(lanes, shift), factor); };
+            for (; i + 16 <= count; i += 16)
+            {
+                __m128i source = _mm_loadu_si128(reinterpret_cast<const __m128i*>(channel + i));
+                __m128i low = quantize_lanes(_mm_unpacklo_epi8(source, zero));
+                __m128i high = quantize_lanes(_mm_unpackhi_epi8(source, zero));
+                __m128i result = _mm_packus_epi16(low, high);
+                result = _mm_or_si128(_mm_andnot_si128(alpha_mask, result), _mm_and_si128(alpha_mask, source));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(channel + i), result);
+            }
+#endif
+            for (; i < count; i++)
+            {
+                if (has_alpha || i % sizeof(Pixel) != 3)
+                {
+                    channel[i] = static_cast<uint8_t>((channel[i] / scale_down_factor) * scale_up_factor);
+                }
+            }
+        }
+    }
+    else if (dither == Dither::Ordered)
+    {
+        // clang-format off
+        const std::array<std::array<int, 8>, 8> bayer = {{
+            {  0, 32,  8, 40,  2, 34, 10, 42 },
+            { 48, 16, 56, 24, 50, 18, 58, 26 },
+            { 12, 44,  4, 36, 14, 46,  6, 38 },
+            { 60, 28, 52, 20, 62, 30, 54, 22 },
+            {  3, 35, 11, 43,  1, 33,  9, 41 },
+            { 51, 19, 59, 27, 49, 17, 57, 25 },
+            { 15, 47,  7, 39, 13, 45,  5, 37 },
+            { 63, 31, 55, 23, 61, 29, 53, 21 }}};
+        // clang-format on
+
+        // One lookup table per matrix cell, with the threshold spanning one quantization step
+        std::vector<std::array<uint8_t, 256>> dither_luts(64);
+        for (int i = 0; i < 64; i++)
+        {
+            int threshold = ((2 * bayer[i / 8][i % 8] + 1) * scale_up_factor) / 128 - scale_up_factor / 2;
+            for (int v = 0; v < 256; v++)
+            {
+                dither_luts[i][v] = nearest_level(v + threshold);
+            }
+        }
+
+        for (int y = 0; y < info_header.height; y++)
+        {
+            const std::array<uint8_t, 256>* row_luts = &dither_luts[(y % 8) * 8];
+            for (int x = 0; x < info_header.width; x++)
+            {
+                const std::array<uint8_t, 256>& cell = row_luts[x % 8];
+                Pixel& pixel = pixels[y][x];
+                pixel.r = cell[pixel.r];
+                pixel.g = cell[pixel.g];
+                pixel.b = cell[pixel.b];
+                if (has_alpha)
+                {
+                    pixel.a = cell[pixel.a];
+                }
+            }
+        }
+    }
+    else
+    {
+        // Errors are kept in 1/16 units. The current row receives the error carried from the previous
+        // row, and the next row accumulates what this row pushes down; both are padded by one pixel.
+        int channels = has_alpha ? 4 : 3;
+        int stride = (info_header.width + 2) * channels;
+        std::vector<int> current_error(stride, 0);
+        std::vector<int> next_error(stride, 0);
+
+        // Walk from the top row down; the rows are stored bottom-up.
+        for (int y = info_header.height - 1; y >= 0; y--)
         {
-            pixels[y][x].r = (pixels[y][x].r / scale_down_factor) * scale_up_factor;
-            pixels[y][x].g = (pixels[y][x].g / scale_down_factor) * scale_up_factor;
-            pixels[y][x].b = (pixels[y][x].b / scale_down_factor) * scale_up_factor;
-            if (info_header.bit_count == 32)
+            std::fill(next_error.begin(), next_error.end(), 0);
+            uint8_t* row = reinterpret_cast<uint8_t*>(pixels[y].data());
+            for (int x = 0; x < info_header.width; x++)
             {
-                pixels[y][x].a = (pixels[y][x].a / scale_down_factor) * scale_up_factor;
+                int* err = &current_error[(x + 1) * channels];
+                int* below = &next_error[(x + 1) * channels];
+                for (int c = 0; c < channels; c++)
+                {
+                    // Values beyond the levels cannot be reached, so their excess is not diffused
+                    int value = std::clamp(row[x * 4 + c] + ((err[c] + 8) >> 4), 0, max_value);
+                    uint8_t out = nearest_level(value);
+                    int e = value - out;
+                    row[x * 4 + c] = out;
+
+                    err[c + channels] += 7 * e;
+                    below[c - channels] += 3 * e;
+                    below[c] += 5 * e;
+                    below[c + channels] += e;
+                }
             }
+            current_error.swap(next_error);
         }
     }
 }
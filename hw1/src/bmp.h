@@ -89,6 +89,20 @@ struct Pixel
     uint8_t r, g, b, a;
 };
 
+/**
+ * @brief The Dither enum selects how quantization error is distributed.
+ * - None: every pixel is rounded independently
+ * - Ordered: an 8x8 Bayer threshold matrix is added before rounding
+ * - FloydSteinberg: the rounding error is diffused to the neighboring pixels
+ *
+ */
+enum class Dither
+{
+    None,
+    Ordered,
+    FloydSteinberg
+};
+
 /**
  * @brief A class representing a BMP (Bitmap) image with various operations for manipulation and I/O.
  *
@@ -102,6 +116,26 @@ class BMPImage
     BMPInfoHeader info_header;
     std::vector<std::vector<Pixel>> pixels;
 
+    /**
+     * @brief Transposes the stored pixel grid (row y, column x becomes row x, column y).
+     * The rows are stored bottom-up, so on screen this mirrors the image over its anti-diagonal.
+     *
+     */
+    void transposePixels();
+
+    /**
+     * @brief Updates the image size fields of the headers after the dimensions change.
+     *
+     */
+    void updateImageSize();
+
+    /**
+     * @brief Creates the directory of a file about to be written, if it does not exist yet.
+     *
+     * @param filename The name of the file.
+     */
+    static void createParentDirectory(const std::string& filename);
+
   public:
     /**
      * @brief Construct a new BMPImage object
@@ -114,16 +148,56 @@ class BMPImage
 
     /**
      * @brief Flips the image horizontally.
+     * Rows are reversed in place, four pixels at a time when SSE2 is available.
      *
      */
     void flipHorizontal();
 
+    /**
+     * @brief Flips the image vertically.
+     * Only the row handles are swapped, so no pixel data is copied.
+     *
+     */
+    void flipVertical();
+
+    /**
+     * @brief Transposes the image over its main (top-left to bottom-right) diagonal.
+     *
+     */
+    void transpose();
+
+    /**
+     * @brief Rotates the image by 90 degrees.
+     *
+     * @param clockwise Whether to rotate clockwise or counterclockwise.
+     */
+    void rotate90(const bool clockwise);
+
+    /**
+     * @brief Rotates the image by 180 degrees.
+     *
+     */
+    void rotate180();
+
+    /**
+     * @brief Normalizes the image to the upright orientation described by an EXIF orientation tag.
+     *
+     * @param orientation The EXIF orientation value (1 to 8).
+     */
+    void normalizeOrientation(const int orientation);
+
     /**
      * @brief Quantize the color depth of the image to a specified bit depth.
+     * Without dithering a value keeps the level of its top bits, a shift and a multiply done 16
+     * channels at a time with SSE2. The dithering modes map a value to its nearest level, a division
+     * by the level step: ordered dithering uses one table per position of an 8x8 Bayer matrix, and
+     * Floyd-Steinberg diffuses the error of each row into a single pending row buffer, with values
+     * clamped to the level range first.
      *
      * @param bit_depth The target bit depth for quantization.
+     * @param dither The dithering method. Dithering requires a bit depth below 8.
      */
-    void quantize(const int bit_depth);
+    void quantize(const int bit_depth, const Dither dither = Dither::None);
 
     /**
      * @brief Scales the image by a specified factor and optionally crops it.
@@ -149,6 +223,15 @@ class BMPImage
      */
     void write(const std::string& filename);
 
+    /**
+     * @brief Writes the image to a palettized BMP file.
+     * The palette holds the distinct colors of the image, and the smallest of 1, 2, 4 or 8 bits
+     * per pixel that can index them is used. Quantize the image first to keep the color count low.
+     *
+     * @param filename The name of the BMP file to write.
+     */
+    void writePalettized(const std::string& filename) const;
+
     // Getters
     // int getWidth() const;
     // int getHeight() const;
@@ -16,22 +16,46 @@
 int main(int argc, char* argv[])
 {
     // Check if the user provided the correct number of arguments.
-    if (argc != 3)
+    if (argc != 3 && argc != 4)
     {
-        std::cerr << "Usage: " << argv[0] << " <input_file> <output_file>" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " <input_file> <output_file> [h|v|t|cw|ccw|180|<exif_orientation>]" << std::endl;
         return 1;
     }
 
-    // Assign the input and output filenames.
+    // Assign the input and output filenames and the operation (horizontal flip by default).
     std::string input_filename(argv[1]);
     std::string output_filename(argv[2]);
+    std::string operation = (argc == 4) ? argv[3] : "h";
 
     try
     {
         BMPImage image(input_filename);
         image.printFileHeader();  // print the file header
         image.printInfoHeader();  // print the info header
-        image.flipHorizontal();
+        if (operation == "h")
+        {
+            image.flipHorizontal();
+        }
+        else if (operation == "v")
+        {
+            image.flipVertical();
+        }
+        else if (operation == "t")
+        {
+            image.transpose();
+        }
+        else if (operation == "cw" || operation == "ccw")
+        {
+            image.rotate90(operation == "cw");
+        }
+        else if (operation == "180")
+        {
+            image.rotate180();
+        }
+        else
+        {
+            image.normalizeOrientation(std::stoi(operation));
+        }
         image.write(output_filename);
         image.printFileHeader();  // print the file header
         image.printInfoHeader();  // print the info header
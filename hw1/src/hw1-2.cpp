@@ -16,9 +16,9 @@
 int main(int argc, char* argv[])
 {
     // Check if the user provided the correct number of arguments.
-    if (argc != 4)
+    if (argc < 4 || argc > 6)
     {
-        std::cerr << "Usage: " << argv[0] << " <input_file> <output_file> <bit_depth>" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " <input_file> <output_file> <bit_depth> [none|ordered|fs] [--palette]" << std::endl;
         return 1;
     }
 
@@ -27,13 +27,49 @@ int main(int argc, char* argv[])
     std::string output_filename(argv[2]);
     int bit_depth = std::stoi(argv[3]);
 
+    // Optional dithering method and palettized output
+    Dither dither = Dither::None;
+    bool palettized = false;
+    for (int i = 4; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "none")
+        {
+            dither = Dither::None;
+        }
+        else if (arg == "ordered")
+        {
+            dither = Dither::Ordered;
+        }
+        else if (arg == "fs")
+        {
+            dither = Dither::FloydSteinberg;
+        }
+        else if (arg == "--palette")
+        {
+            palettized = true;
+        }
+        else
+        {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+
     try
     {
         BMPImage image(input_filename);
         image.printFileHeader();  // print the file header
         image.printInfoHeader();  // print the info header
-        image.quantize(bit_depth);
-        image.write(output_filename);
+        image.quantize(bit_depth, dither);
+        if (palettized)
+        {
+            image.writePalettized(output_filename);
+        }
+        else
+        {
+            image.write(output_filename);
+        }
         image.printFileHeader();  // print the file header
         image.printInfoHeader();  // print the info header
     }
@@ -0,0 +1,151 @@
+/**
+ * @file quantize_test.cpp
+ * @author sunfu-chou (sunfu-chou@gmail.com)
+ * @brief Checks BMPImage::quantize on images with known answers.
+ * @version 0.1
+ * @date 2023-10-18
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "bmp.h"
+
+namespace
+{
+const int kWidth = 64;
+const int kHeight = 64;
+const int kHeaderSize = 54;
+
+/**
+ * @brief Writes a 24-bit gray BMP; gray(x, y) gives the value with y counted from the top row.
+ */
+template <typename Gray>
+void writeGray(const std::string& filename, Gray gray)
+{
+    int row_size = (kWidth * 3 + 3) / 4 * 4;
+    std::vector<uint8_t> data(kHeaderSize + row_size * kHeight, 0);
+    auto put32 = [&](int offset, uint32_t value) {
+        for (int i = 0; i < 4; i++)
+        {
+            data[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    };
+    data[0] = 'B';
+    data[1] = 'M';
+    put32(2, data.size());
+    put32(10, kHeaderSize);
+    put32(14, 40);
+    put32(18, kWidth);
+    put32(22, kHeight);
+    data[26] = 1;
+    data[28] = 24;
+    put32(34, row_size * kHeight);
+    for (int y = 0; y < kHeight; y++)
+    {
+        uint8_t* row = &data[kHeaderSize + (kHeight - 1 - y) * row_size];
+        for (int x = 0; x < kWidth; x++)
+        {
+            row[3 * x] = row[3 * x + 1] = row[3 * x + 2] = gray(x, y);
+        }
+    }
+    std::ofstream(filename, std::ios::binary).write(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+/**
+ * @brief Reads the first channel of a 24-bit BMP written by BMPImage, with y counted from the top row.
+ */
+std::vector<std::vector<int>> readGray(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    int row_size = (kWidth * 3 + 3) / 4 * 4;
+    std::vector<std::vector<int>> gray(kHeight, std::vector<int>(kWidth));
+    for (int y = 0; y < kHeight; y++)
+    {
+        const uint8_t* row = &data[kHeaderSize + (kHeight - 1 - y) * row_size];
+        for (int x = 0; x < kWidth; x++)
+        {
+            gray[y][x] = row[3 * x];
+        }
+    }
+    return gray;
+}
+
+std::vector<std::vector<int>> quantized(const std::string& input, int bit_depth, Dither dither)
+{
+    BMPImage image(input);
+    image.quantize(bit_depth, dither);
+    std::string output = input + ".out.bmp";
+    image.write(output);
+    std::vector<std::vector<int>> gray = readGray(output);
+    std::remove(output.c_str());
+    return gray;
+}
+
+int failures = 0;
+
+void check(bool condition, const std::string& message)
+{
+    if (!condition)
+    {
+        std::cerr << "FAIL: " << message << std::endl;
+        failures++;
+    }
+}
+}  // namespace
+
+int main()
+{
+    const std::string edge = "./quantize_test_edge.bmp";
+    const std::string flat = "./quantize_test_flat.bmp";
+    writeGray(edge, [](int, int y) { return y < kHeight / 2 ? 255 : 0; });
+    writeGray(flat, [](int, int) { return 95; });
+
+    // White above black: the top level cannot reach 255, and that excess must not leak into the black half
+    for (int bit_depth : { 2, 4, 6 })
+    {
+        std::vector<std::vector<int>> gray = quantized(edge, bit_depth, Dither::FloydSteinberg);
+        int lit = 0;
+        for (int y = kHeight / 2; y < kHeight; y++)
+        {
+            for (int x = 0; x < kWidth; x++)
+            {
+                lit += gray[y][x] != 0;
+            }
+        }
+        check(lit == 0, std::to_string(lit) + " black pixels lit at " + std::to_string(bit_depth) + " bits");
+    }
+
+    // A flat region keeps the level of its top bits without dithering and averages near its value with either
+    // dithering
+    std::vector<std::vector<int>> none = quantized(flat, 2, Dither::None);
+    for (Dither dither : { Dither::Ordered, Dither::FloydSteinberg })
+    {
+        std::vector<std::vector<int>> gray = quantized(flat, 2, dither);
+        double sum = 0;
+        for (const auto& row : gray)
+        {
+            for (int value : row)
+            {
+                sum += value;
+            }
+        }
+        double mean = sum / (kWidth * kHeight);
+        check(mean > 80 && mean < 110, "dithered flat 95 averages " + std::to_string(mean));
+    }
+    check(none[0][0] == 63, "flat 95 maps to " + std::to_string(none[0][0]));
+
+    std::remove(edge.c_str());
+    std::remove(flat.c_str());
+    if (failures == 0)
+    {
+        std::cout << "All quantize tests passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -19,6 +19,12 @@
 #include <stdexcept>
 #include <iostream>
 #include <cmath>
+#include <cstring>
+#include <thread>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 BMPImage::BMPImage(const std::string& filename)
 {
@@ -391,3 +397,652 @@ void BMPImage::printInfoHeader() const
     std::cout << std::left << std::setw(print_width) << "important_colors:" << info_header.important_colors << std::endl;
     std::cout << std::endl;
 }
+
+namespace
+{
+/**
+ * @brief Mirrors an index into [0, size) without repeating the edge element.
+ */
+int reflectIndex(int i, int size)
+{
+    if (size == 1)
+    {
+        return 0;
+    }
+    while (i < 0 || i >= size)
+    {
+        i = (i < 0) ? -i : 2 * (size - 1) - i;
+    }
+    return i;
+}
+
+/**
+ * @brief Sorts two rows element-wise so that a holds the minima and b the maxima.
+ */
+void sortRows(std::vector<uint8_t>& a, std::vector<uint8_t>& b)
+{
+    uint8_t* pa = a.data();
+    uint8_t* pb = b.data();
+    size_t size = a.size();
+    size_t i = 0;
+#ifdef __SSE2__
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pa + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pb + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pa + i), _mm_min_epu8(va, vb));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pb + i), _mm_max_epu8(va, vb));
+    }
+#endif
+    for (; i < size; ++i)
+    {
+        uint8_t lo = std::min(pa[i], pb[i]);
+        uint8_t hi = std::max(pa[i], pb[i]);
+        pa[i] = lo;
+        pb[i] = hi;
+    }
+}
+
+// Median-of-9 and median-of-25 sorting networks (N. Devillard, "Fast median search: an ANSI C implementation").
+// clang-format off
+const std::vector<std::pair<int, int>> MEDIAN9_NETWORK = {
+    { 1, 2 }, { 4, 5 }, { 7, 8 }, { 0, 1 }, { 3, 4 }, { 6, 7 }, { 1, 2 }, { 4, 5 }, { 7, 8 }, { 0, 3 },
+    { 5, 8 }, { 4, 7 }, { 3, 6 }, { 1, 4 }, { 2, 5 }, { 4, 7 }, { 4, 2 }, { 6, 4 }, { 4, 2 } };
+
+const std::vector<std::pair<int, int>> MEDIAN25_NETWORK = {
+    { 0, 1 },   { 3, 4 },   { 2, 4 },   { 2, 3 },   { 6, 7 },   { 5, 7 },   { 5, 6 },   { 9, 10 },  { 8, 10 },  { 8, 9 },
+    { 12, 13 }, { 11, 13 }, { 11, 12 }, { 15, 16 }, { 14, 16 }, { 14, 15 }, { 18, 19 }, { 17, 19 }, { 17, 18 }, { 21, 22 },
+    { 20, 22 }, { 20, 21 }, { 23, 24 }, { 2, 5 },   { 3, 6 },   { 0, 6 },   { 0, 3 },   { 4, 7 },   { 1, 7 },   { 1, 4 },
+    { 11, 14 }, { 8, 14 },  { 8, 11 },  { 12, 15 }, { 9, 15 },  { 9, 12 },  { 13, 16 }, { 10, 16 }, { 10, 13 }, { 20, 23 },
+    { 17, 23 }, { 17, 20 }, { 21, 24 }, { 18, 24 }, { 18, 21 }, { 19, 22 }, { 8, 17 },  { 9, 18 },  { 0, 18 },  { 0, 9 },
+    { 10, 19 }, { 1, 19 },  { 1, 10 },  { 11, 20 }, { 2, 20 },  { 2, 11 },  { 12, 21 }, { 3, 21 },  { 3, 12 },  { 13, 22 },
+    { 4, 22 },  { 4, 13 },  { 14, 23 }, { 5, 23 },  { 5, 14 },  { 15, 24 }, { 6, 24 },  { 6, 15 },  { 7, 16 },  { 7, 19 },
+    { 13, 21 }, { 15, 23 }, { 7, 13 },  { 7, 15 },  { 1, 9 },   { 3, 11 },  { 5, 17 },  { 11, 17 }, { 9, 17 },  { 4, 10 },
+    { 6, 12 },  { 7, 14 },  { 4, 6 },   { 4, 7 },   { 12, 14 }, { 10, 14 }, { 6, 7 },   { 10, 12 }, { 6, 10 },  { 6, 17 },
+    { 12, 17 }, { 7, 17 },  { 7, 10 },  { 12, 18 }, { 7, 12 },  { 10, 18 }, { 12, 20 }, { 10, 20 }, { 10, 12 } };
+// clang-format on
+
+/**
+ * @brief Median filter of one padded channel plane using a sorting network over whole rows.
+ * Every window element is copied into its own row buffer, and each compare-exchange step runs
+ * element-wise over a pair of rows with packed min/max instructions.
+ */
+void medianNetwork(const std::vector<uint8_t>& plane, int padded_width, int width, int height, int radius,
+                   const std::vector<std::pair<int, int>>& network, std::vector<uint8_t>& output)
+{
+    int size = 2 * radius + 1;
+    std::vector<std::vector<uint8_t>> rows(size * size, std::vector<uint8_t>(width));
+    for (int y = 0; y < height; ++y)
+    {
+        for (int i = 0; i < size; ++i)
+        {
+            for (int j = 0; j < size; ++j)
+            {
+                std::memcpy(rows[i * size + j].data(), &plane[static_cast<size_t>(y + i) * padded_width + j], width);
+            }
+        }
+        for (const auto& [a, b] : network)
+        {
+            sortRows(rows[a], rows[b]);
+        }
+        std::memcpy(&output[static_cast<size_t>(y) * width], rows[size * size / 2].data(), width);
+    }
+}
+
+/**
+ * @brief Adds a 16-bit histogram segment of N bins to another.
+ */
+template <int N>
+void addHistogram(uint16_t* target, const uint16_t* source)
+{
+#ifdef __SSE2__
+    for (int i = 0; i < N; i += 8)
+    {
+        __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(target + i));
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(target + i), _mm_add_epi16(t, s));
+    }
+#else
+    for (int i = 0; i < N; ++i)
+    {
+        target[i] += source[i];
+    }
+#endif
+}
+
+/**
+ * @brief Adds the histogram segment entering a sliding window and subtracts the one leaving it.
+ */
+template <int N>
+void slideHistogram(uint16_t* target, const uint16_t* entering, const uint16_t* leaving)
+{
+#ifdef __SSE2__
+    for (int i = 0; i < N; i += 8)
+    {
+        __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(target + i));
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(entering + i));
+        __m128i out = _mm_loadu_si128(reinterpret_cast<const __m128i*>(leaving + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(target + i), _mm_sub_epi16(_mm_add_epi16(t, in), out));
+    }
+#else
+    for (int i = 0; i < N; ++i)
+    {
+        target[i] = static_cast<uint16_t>(target[i] + entering[i] - leaving[i]);
+    }
+#endif
+}
+
+/**
+ * @brief Median filter of one padded channel plane in constant time per pixel (Perreault-Hebert).
+ * Every column keeps a histogram of the 2r+1 values above it. The window keeps a 16-bin coarse
+ * histogram that slides right by adding the entering column and subtracting the leaving one.
+ * The 256-bin fine histogram is only brought up to date for the coarse bin holding the median,
+ * so each pixel touches about 32 bins whatever the radius.
+ */
+void medianHistogram(const std::vector<uint8_t>& plane, int padded_width, int width, int height, int radius, std::vector<uint8_t>& output)
+{
+    int size = 2 * radius + 1;
+    int rank = size * size / 2;
+
+    std::vector<uint16_t> column_fine(static_cast<size_t>(padded_width) * 256, 0);
+    std::vector<uint16_t> column_coarse(static_cast<size_t>(padded_width) * 16, 0);
+    auto update_columns = [&](int row, int delta) {
+        const uint8_t* values = &plane[static_cast<size_t>(row) * padded_width];
+        for (int x = 0; x < padded_width; ++x)
+        {
+            column_fine[x * 256 + values[x]] += delta;
+            column_coarse[x * 16 + (values[x] >> 4)] += delta;
+        }
+    };
+    for (int row = 0; row < size; ++row)
+    {
+        update_columns(row, 1);
+    }
+
+    alignas(16) uint16_t fine[256];
+    alignas(16) uint16_t coarse[16];
+    int fine_position[16];  // left edge of the window each fine segment was last computed for
+    for (int y = 0; y < height; ++y)
+    {
+        std::memset(coarse, 0, sizeof(coarse));
+        for (int x = 0; x < size; ++x)
+        {
+            addHistogram<16>(coarse, &column_coarse[x * 16]);
+        }
+        std::fill(std::begin(fine_position), std::end(fine_position), -size);
+
+        uint8_t* out = &output[static_cast<size_t>(y) * width];
+        for (int x = 0; x < width; ++x)
+        {
+            // Find the coarse bin holding the median
+            int count = 0;
+            int bucket = 0;
+            while (count + coarse[bucket] <= rank)
+            {
+                count += coarse[bucket++];
+            }
+
+            // Bring its fine segment up to date, by sliding if the window moved less than its width
+            uint16_t* segment = &fine[bucket * 16];
+            if (x - fine_position[bucket] < size)
+            {
+                for (int k = fine_position[bucket]; k < x; ++k)
+                {
+                    slideHistogram<16>(segment, &column_fine[(k + size) * 256 + bucket * 16], &column_fine[k * 256 + bucket * 16]);
+                }
+            }
+            else
+            {
+                std::memset(segment, 0, 16 * sizeof(uint16_t));
+                for (int k = x; k < x + size; ++k)
+                {
+                    addHistogram<16>(segment, &column_fine[k * 256 + bucket * 16]);
+                }
+            }
+            fine_position[bucket] = x;
+
+            // Find the fine bin holding the median
+            int value = 0;
+            while (count + segment[value] <= rank)
+            {
+                count += segment[value++];
+            }
+            out[x] = static_cast<uint8_t>(bucket * 16 + value);
+
+            if (x + 1 < width)
+            {
+                slideHistogram<16>(coarse, &column_coarse[(x + size) * 16], &column_coarse[x * 16]);
+            }
+        }
+
+        // Slide the column histograms down by one row
+        if (y + 1 < height)
+        {
+            update_columns(y, -1);
+            update_columns(y + size, 1);
+        }
+    }
+}
+}  // namespace
+
+void BMPImage::applyMedianFilter(int radius)
+{
+    if (radius < 1 || radius > 127)
+    {
+        throw std::runtime_error("Median radius must be between 1 and 127");
+    }
+
+    int width = info_header.width;
+    int height = info_header.height;
+    int padded_width = width + 2 * radius;
+    int padded_height = height + 2 * radius;
+
+    // Mirrored source coordinates of the padded plane
+    std::vector<int> source_x(padded_width), source_y(padded_height);
+    for (int x = 0; x < padded_width; ++x)
+    {
+        source_x[x] = reflectIndex(x - radius, width);
+    }
+    for (int y = 0; y < padded_height; ++y)
+    {
+        source_y[y] = reflectIndex(y - radius, height);
+    }
+
+    std::vector<uint8_t> plane(static_cast<size_t>(padded_width) * padded_height);
+    std::vector<uint8_t> output(static_cast<size_t>(width) * height);
+    for (int c = 0; c < 3; ++c)
+    {
+        // Extract the padded channel plane
+        for (int y = 0; y < padded_height; ++y)
+        {
+            const std::vector<Pixel>& row = pixels[source_y[y]];
+            uint8_t* out = &plane[static_cast<size_t>(y) * padded_width];
+            for (int x = 0; x < padded_width; ++x)
+            {
+                out[x] = (&row[source_x[x]].r)[c];
+            }
+        }
+
+        if (radius == 1)
+        {
+            medianNetwork(plane, padded_width, width, height, radius, MEDIAN9_NETWORK, output);
+        }
+        else if (radius == 2)
+        {
+            medianNetwork(plane, padded_width, width, height, radius, MEDIAN25_NETWORK, output);
+        }
+        else
+        {
+            medianHistogram(plane, padded_width, width, height, radius, output);
+        }
+
+        // Write the filtered channel back
+        for (int y = 0; y < height; ++y)
+        {
+            const uint8_t* filtered = &output[static_cast<size_t>(y) * width];
+            for (int x = 0; x < width; ++x)
+            {
+                (&pixels[y][x].r)[c] = filtered[x];
+            }
+        }
+    }
+}
+
+namespace
+{
+/**
+ * @brief Returns the number of worker threads to use for splitting count items.
+ */
+int threadCount(int count)
+{
+    int hardware_threads = static_cast<int>(std::thread::hardware_concurrency());
+    return std::clamp(hardware_threads, 1, std::max(count, 1));
+}
+
+/**
+ * @brief Returns the first item of a chunk when [0, count) is split into contiguous chunks.
+ */
+int chunkBegin(int count, int chunks, int chunk)
+{
+    return static_cast<int>(static_cast<long long>(count) * chunk / chunks);
+}
+
+/**
+ * @brief Splits [0, count) into contiguous chunks and runs func(begin, end) for each chunk on its own thread.
+ * The calling thread takes the first chunk, so a single chunk starts no thread at all.
+ */
+template <typename Func>
+void parallelFor(int count, Func func)
+{
+    int chunks = threadCount(count);
+    std::vector<std::thread> workers;
+    workers.reserve(chunks);
+    for (int chunk = 1; chunk < chunks; ++chunk)
+    {
+        workers.emplace_back(func, chunkBegin(count, chunks, chunk), chunkBegin(count, chunks, chunk + 1));
+    }
+    func(0, chunkBegin(count, chunks, 1));
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+/**
+ * @brief Box-filters a plane: each output is the mean of the window of the given radius, clipped to the plane.
+ * Running column sums and a sliding row sum make the cost independent of the radius. The column sums
+ * are run over strips of columns and the row sums over bands of rows, each on its own thread; every
+ * sum is accumulated in the same order as a single pass would, so the result does not depend on the
+ * thread count.
+ */
+void boxFilter(const std::vector<float>& input, std::vector<float>& output, int width, int height, int radius)
+{
+    // Reciprocal sizes of the clipped windows
+    std::vector<double> inverse_count_x(width), inverse_count_y(height);
+    for (int x = 0; x < width; ++x)
+    {
+        inverse_count_x[x] = 1.0 / (std::min(x + radius, width - 1) - std::max(x - radius, 0) + 1);
+    }
+    for (int y = 0; y < height; ++y)
+    {
+        inverse_count_y[y] = 1.0 / (std::min(y + radius, height - 1) - std::max(y - radius, 0) + 1);
+    }
+
+    // Vertical window sums of every row, each strip of columns sliding down the whole plane
+    std::vector<double> columns(static_cast<size_t>(width) * height);
+    parallelFor(width, [&](int begin, int end) {
+        std::vector<double> column(end - begin, 0.0);
+        for (int y = 0; y < std::min(radius, height); ++y)
+        {
+            const float* in = &input[static_cast<size_t>(y) * width + begin];
+            for (int x = 0; x < end - begin; ++x)
+            {
+                column[x] += in[x];
+            }
+        }
+
+        for (int y = 0; y < height; ++y)
+        {
+            if (y + radius < height)
+            {
+                const float* entering = &input[static_cast<size_t>(y + radius) * width + begin];
+                for (int x = 0; x < end - begin; ++x)
+                {
+                    column[x] += entering[x];
+                }
+            }
+            if (y - radius - 1 >= 0)
+            {
+                const float* leaving = &input[static_cast<size_t>(y - radius - 1) * width + begin];
+                for (int x = 0; x < end - begin; ++x)
+                {
+                    column[x] -= leaving[x];
+                }
+            }
+            std::copy(column.begin(), column.end(), &columns[static_cast<size_t>(y) * width + begin]);
+        }
+    });
+
+    // Slide the horizontal window over the column sums of each row
+    parallelFor(height, [&](int begin, int end) {
+        for (int y = begin; y < end; ++y)
+        {
+            const double* column = &columns[static_cast<size_t>(y) * width];
+            float* out = &output[static_cast<size_t>(y) * width];
+            double sum = 0.0;
+            for (int x = 0; x < std::min(radius, width); ++x)
+            {
+                sum += column[x];
+            }
+            for (int x = 0; x < width; ++x)
+            {
+                if (x + radius < width)
+                {
+                    sum += column[x + radius];
+                }
+                if (x - radius - 1 >= 0)
+                {
+                    sum -= column[x - radius - 1];
+                }
+                out[x] = static_cast<float>(sum * inverse_count_x[x] * inverse_count_y[y]);
+            }
+        }
+    });
+}
+
+/**
+ * @brief Adds the channel values and their squares of a row to per-block sums (4 interleaved channels per block).
+ */
+void accumulateBlocks(const Pixel* row, int width, int block_size, int32_t* sums, int32_t* squares)
+{
+    for (int x = 0, block = 0; x < width; ++block)
+    {
+        int end = std::min(x + block_size, width);
+#ifdef __SSE2__
+        const __m128i zero = _mm_setzero_si128();
+        __m128i sum = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + 4 * block));
+        __m128i square = _mm_loadu_si128(reinterpret_cast<const __m128i*>(squares + 4 * block));
+        for (; x < end; ++x)
+        {
+            int32_t packed;
+            std::memcpy(&packed, &row[x], sizeof(packed));
+            __m128i words = _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero);
+            sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(words, zero));
+            square = _mm_add_epi32(square, _mm_unpacklo_epi16(_mm_mullo_epi16(words, words), zero));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + 4 * block), sum);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(squares + 4 * block), square);
+#else
+        for (; x < end; ++x)
+        {
+            const uint8_t* channels = &row[x].r;
+            for (int c = 0; c < 4; ++c)
+            {
+                sums[4 * block + c] += channels[c];
+                squares[4 * block + c] += channels[c] * channels[c];
+            }
+        }
+#endif
+    }
+}
+
+/**
+ * @brief Bilinear slicing position of a full-resolution coordinate on a grid downsampled by the given factor.
+ * Grid cell i covers the full-resolution samples [i * factor, (i + 1) * factor), so its center lies at
+ * (i + 0.5) * factor - 0.5.
+ */
+void slicePosition(int full, int factor, int grid_size, int& lower, int& upper, float& weight)
+{
+    float position = (full + 0.5f) / factor - 0.5f;
+    position = std::max(0.0f, std::min(position, static_cast<float>(grid_size - 1)));
+    lower = static_cast<int>(position);
+    upper = std::min(lower + 1, grid_size - 1);
+    weight = position - lower;
+}
+
+/**
+ * @brief Applies q = a * I + b to a row of bytes, with a and b interpolated between two coefficient rows.
+ */
+void sliceRow(uint8_t* data, size_t count, const float* lower_a, const float* upper_a, const float* lower_b,
+              const float* upper_b, float weight)
+{
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128 vweight = _mm_set1_ps(weight);
+    const __m128 vhalf = _mm_set1_ps(0.5f);
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i words[2] = {_mm_unpacklo_epi8(bytes, zero), _mm_unpackhi_epi8(bytes, zero)};
+        __m128i results[4];
+        for (int k = 0; k < 4; ++k)
+        {
+            __m128i dwords = (k % 2 == 0) ? _mm_unpacklo_epi16(words[k / 2], zero) : _mm_unpackhi_epi16(words[k / 2], zero);
+            size_t j = i + 4 * k;
+            __m128 a0 = _mm_loadu_ps(lower_a + j);
+            __m128 b0 = _mm_loadu_ps(lower_b + j);
+            __m128 a = _mm_add_ps(a0, _mm_mul_ps(vweight, _mm_sub_ps(_mm_loadu_ps(upper_a + j), a0)));
+            __m128 b = _mm_add_ps(b0, _mm_mul_ps(vweight, _mm_sub_ps(_mm_loadu_ps(upper_b + j), b0)));
+            __m128 value = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, _mm_cvtepi32_ps(dwords)), b), vhalf);
+            results[k] = _mm_cvttps_epi32(_mm_max_ps(value, _mm_setzero_ps()));
+        }
+        // Saturating packs clamp the results to 255
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(results[0], results[1]), _mm_packs_epi32(results[2], results[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), packed);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        float a = lower_a[i] + weight * (upper_a[i] - lower_a[i]);
+        float b = lower_b[i] + weight * (upper_b[i] - lower_b[i]);
+        float value = a * data[i] + b + 0.5f;
+        data[i] = static_cast<uint8_t>(std::max(0.0f, std::min(value, 255.0f)));
+    }
+}
+}  // namespace
+
+void BMPImage::applyGuidedFilter(int radius, float epsilon, int subsample)
+{
+    if (radius < 1)
+    {
+        throw std::runtime_error("Guided filter radius must be positive");
+    }
+    if (epsilon <= 0)
+    {
+        throw std::runtime_error("Guided filter epsilon must be greater than 0");
+    }
+    if (subsample < 1 || subsample > 128)
+    {
+        throw std::runtime_error("Guided filter subsample factor must be between 1 and 128");
+    }
+
+    int width = info_header.width;
+    int height = info_header.height;
+    int grid_width = (width + subsample - 1) / subsample;
+    int grid_height = (height + subsample - 1) / subsample;
+    int grid_radius = std::max(1, static_cast<int>(std::lround(static_cast<double>(radius) / subsample)));
+    size_t grid_size = static_cast<size_t>(grid_width) * grid_height;
+    float regularization = epsilon * 255.0f * 255.0f;
+
+    // Downsample the channels and their squares by averaging subsample x subsample blocks. Averaging the
+    // squares at full resolution keeps the variance inside each block in the window statistics.
+    std::vector<float> mean[3], mean_squared[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        mean[c].resize(grid_size);
+        mean_squared[c].resize(grid_size);
+    }
+    parallelFor(grid_height, [&](int begin, int end) {
+        std::vector<int32_t> block_sums(static_cast<size_t>(grid_width) * 4);
+        std::vector<int32_t> block_squares(static_cast<size_t>(grid_width) * 4);
+        for (int gy = begin; gy < end; ++gy)
+        {
+            int top = gy * subsample;
+            int block_height = std::min(subsample, height - top);
+            std::fill(block_sums.begin(), block_sums.end(), 0);
+            std::fill(block_squares.begin(), block_squares.end(), 0);
+            for (int y = top; y < top + block_height; ++y)
+            {
+                accumulateBlocks(pixels[y].data(), width, subsample, block_sums.data(), block_squares.data());
+            }
+
+            size_t offset = static_cast<size_t>(gy) * grid_width;
+            for (int gx = 0; gx < grid_width; ++gx)
+            {
+                int block_width = std::min(subsample, width - gx * subsample);
+                float inverse_area = 1.0f / (block_width * block_height);
+                for (int c = 0; c < 3; ++c)
+                {
+                    mean[c][offset + gx] = block_sums[4 * gx + c] * inverse_area;
+                    mean_squared[c][offset + gx] = block_squares[4 * gx + c] * inverse_area;
+                }
+            }
+        }
+    });
+
+    // Linear coefficients q = a * I + b of every window, averaged over the windows covering each cell
+    std::vector<float> mean_a[3], mean_b[3];
+    std::vector<float> a(grid_size), b(grid_size);
+    for (int c = 0; c < 3; ++c)
+    {
+        boxFilter(mean[c], a, grid_width, grid_height, grid_radius);
+        boxFilter(mean_squared[c], b, grid_width, grid_height, grid_radius);
+        parallelFor(grid_height, [&](int begin, int end) {
+            for (size_t i = static_cast<size_t>(begin) * grid_width; i < static_cast<size_t>(end) * grid_width; ++i)
+            {
+                float window_mean = a[i];
+                float variance = std::max(b[i] - window_mean * window_mean, 0.0f);
+                a[i] = variance / (variance + regularization);
+                b[i] = window_mean - a[i] * window_mean;
+            }
+        });
+        // The block means are no longer needed, so they receive the averaged coefficients
+        mean_a[c].swap(mean[c]);
+        mean_b[c].swap(mean_squared[c]);
+        boxFilter(a, mean_a[c], grid_width, grid_height, grid_radius);
+        boxFilter(b, mean_b[c], grid_width, grid_height, grid_radius);
+    }
+
+    // Slice the coefficient grid back to full resolution. A grid row is first interpolated horizontally
+    // into the interleaved pixel layout (the alpha byte keeps a = 1, b = 0), so every image row only
+    // needs a vertical blend of two cached rows. Each band of image rows keeps its own cached rows.
+    std::vector<int> lower_x(width), upper_x(width);
+    std::vector<float> weight_x(width);
+    for (int x = 0; x < width; ++x)
+    {
+        slicePosition(x, subsample, grid_width, lower_x[x], upper_x[x], weight_x[x]);
+    }
+
+    size_t row_size = static_cast<size_t>(width) * 4;
+    auto expandRow = [&](int gy, std::vector<float>& row_a, std::vector<float>& row_b)
+    {
+        size_t offset = static_cast<size_t>(gy) * grid_width;
+        for (int x = 0; x < width; ++x)
+        {
+            size_t x0 = offset + lower_x[x];
+            size_t x1 = offset + upper_x[x];
+            float wx = weight_x[x];
+            for (int c = 0; c < 3; ++c)
+            {
+                row_a[4 * x + c] = mean_a[c][x0] + wx * (mean_a[c][x1] - mean_a[c][x0]);
+                row_b[4 * x + c] = mean_b[c][x0] + wx * (mean_b[c][x1] - mean_b[c][x0]);
+            }
+            row_a[4 * x + 3] = 1.0f;
+            row_b[4 * x + 3] = 0.0f;
+        }
+    };
+
+    parallelFor(height, [&](int begin, int end) {
+        std::vector<float> lower_a(row_size), lower_b(row_size), upper_a(row_size), upper_b(row_size);
+        int loaded_lower = -1, loaded_upper = -1;
+        for (int y = begin; y < end; ++y)
+        {
+            int lower_y, upper_y;
+            float weight_y;
+            slicePosition(y, subsample, grid_height, lower_y, upper_y, weight_y);
+            if (lower_y != loaded_lower)
+            {
+                if (lower_y == loaded_upper)
+                {
+                    std::swap(lower_a, upper_a);
+                    std::swap(lower_b, upper_b);
+                    loaded_upper = -1;
+                }
+                else
+                {
+                    expandRow(lower_y, lower_a, lower_b);
+                }
+                loaded_lower = lower_y;
+            }
+            if (upper_y != loaded_upper)
+            {
+                expandRow(upper_y, upper_a, upper_b);
+                loaded_upper = upper_y;
+            }
+
+            sliceRow(reinterpret_cast<uint8_t*>(pixels[y].data()), row_size, lower_a.data(), upper_a.data(),
+                     lower_b.data(), upper_b.data(), weight_y);
+        }
+    });
+}
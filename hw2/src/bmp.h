@@ -152,6 +152,30 @@ class BMPImage
      */
     void applyGaussianSmoothing(int kernelSize, float sigma);
 
+    /**
+     * @brief Applies a median filter to the BMP image.
+     * The median filter removes impulse (salt-and-pepper) noise while keeping edges. Radius 1 (3x3)
+     * and radius 2 (5x5) use sorting networks evaluated on whole rows; larger radii use sliding
+     * column histograms (Perreault-Hebert), so the cost per pixel does not grow with the radius.
+     * The borders are mirrored.
+     *
+     * @param radius The radius of the square window; the window size is 2 * radius + 1 (1 to 127).
+     */
+    void applyMedianFilter(int radius);
+
+    /**
+     * @brief Applies an edge-preserving guided filter to the BMP image.
+     * Each channel is used as its own guide (He et al., "Guided Image Filtering"). All window means
+     * are running-sum box filters, so the cost does not depend on the radius. The linear coefficients
+     * are computed on a grid downsampled by the subsample factor and bilinearly sliced back to full
+     * resolution, which keeps large frames fast at little loss of quality.
+     *
+     * @param radius The radius of the window in full-resolution pixels.
+     * @param epsilon The regularization on the [0, 1] intensity scale; larger values smooth stronger edges.
+     * @param subsample The downsampling factor of the coefficient grid (1 to 128; 1 disables downsampling).
+     */
+    void applyGuidedFilter(int radius, float epsilon, int subsample = 4);
+
     // File I/O
     /**
      * @brief Reads an image from a BMP file.
@@ -0,0 +1,45 @@
+/**
+ * @file hw2-4.cpp
+ * @author sunfu-chou (sunfu-chou@gmail.com)
+ * @brief This hw2-4
+ * @version 0.1
+ * @date 2023-11-06
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "bmp.h"
+
+int main(int argc, char* argv[])
+{
+    // Check if the user provided the correct number of arguments.
+    if (argc != 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " <input_file> <output_file> <radius>" << std::endl;
+        return 1;
+    }
+
+    // Assign the input and output filenames and the window radius.
+    std::string input_filename(argv[1]);
+    std::string output_filename(argv[2]);
+    int radius = std::stoi(argv[3]);  // convert string to int
+
+    try
+    {
+        BMPImage image(input_filename);  // read the input file
+        // Apply the median filter to the image.
+        image.applyMedianFilter(radius);
+        image.write(output_filename);  // write to the output file
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << GREEN << "Median filtering completed successfully!" << RESET << std::endl;
+    return 0;
+}
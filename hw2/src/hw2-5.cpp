@@ -0,0 +1,47 @@
+/**
+ * @file hw2-5.cpp
+ * @author sunfu-chou (sunfu-chou@gmail.com)
+ * @brief This hw2-5
+ * @version 0.1
+ * @date 2023-11-06
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "bmp.h"
+
+int main(int argc, char* argv[])
+{
+    // Check if the user provided the correct number of arguments.
+    if (argc != 5 && argc != 6)
+    {
+        std::cerr << "Usage: " << argv[0] << " <input_file> <output_file> <radius> <epsilon> [subsample]" << std::endl;
+        return 1;
+    }
+
+    // Assign the input and output filenames, window radius, epsilon, and subsample factor.
+    std::string input_filename(argv[1]);
+    std::string output_filename(argv[2]);
+    int radius = std::stoi(argv[3]);                       // convert string to int
+    float epsilon = std::stof(argv[4]);                    // convert string to float
+    int subsample = (argc == 6) ? std::stoi(argv[5]) : 4;  // convert string to int
+
+    try
+    {
+        BMPImage image(input_filename);  // read the input file
+        // Apply the guided filter to the image.
+        image.applyGuidedFilter(radius, epsilon, subsample);
+        image.write(output_filename);  // write to the output file
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << GREEN << "Guided filtering completed successfully!" << RESET << std::endl;
+    return 0;
+}
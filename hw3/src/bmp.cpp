@@ -15,10 +15,339 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+/**
+ * @brief Returns the number of worker threads to use for splitting count items.
+ */
+int threadCount(int count)
+{
+    int hardware_threads = static_cast<int>(std::thread::hardware_concurrency());
+    return std::clamp(hardware_threads, 1, std::max(count, 1));
+}
+
+/**
+ * @brief Returns the first item of a chunk when [0, count) is split into contiguous chunks.
+ */
+int chunkBegin(int count, int chunks, int chunk)
+{
+    return static_cast<int>(static_cast<long long>(count) * chunk / chunks);
+}
+
+/**
+ * @brief Splits [0, count) into contiguous chunks and runs func(chunk, begin, end) for each chunk on its own thread.
+ * The calling thread takes the first chunk, so a single chunk starts no thread at all.
+ */
+template <typename Func>
+void parallelFor(int count, int chunks, Func func)
+{
+    std::vector<std::thread> workers;
+    workers.reserve(chunks);
+    for (int chunk = 1; chunk < chunks; ++chunk)
+    {
+        workers.emplace_back(func, chunk, chunkBegin(count, chunks, chunk), chunkBegin(count, chunks, chunk + 1));
+    }
+    if (chunks > 0)
+    {
+        func(0, 0, chunkBegin(count, chunks, 1));
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+/**
+ * @brief Sums the r, g and b values of a row.
+ */
+std::array<uint64_t, 3> channelSums(const std::vector<Pixel>& row)
+{
+    std::array<uint64_t, 3> sums{};
+    size_t x = 0;
+#ifdef __SSE2__
+    // Four pixels per step: each channel is masked out of the 16 bytes and summed by _mm_sad_epu8 into two 64-bit lanes
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i masks[3] = { _mm_set1_epi32(0x000000FF), _mm_set1_epi32(0x0000FF00), _mm_set1_epi32(0x00FF0000) };
+    __m128i totals[3] = { zero, zero, zero };
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(row.data());
+    for (; x + 4 <= row.size(); x += 4)
+    {
+        __m128i quad = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + 4 * x));
+        for (int c = 0; c < 3; ++c)
+        {
+            totals[c] = _mm_add_epi64(totals[c], _mm_sad_epu8(_mm_and_si128(quad, masks[c]), zero));
+        }
+    }
+    for (int c = 0; c < 3; ++c)
+    {
+        uint64_t lanes[2];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), totals[c]);
+        sums[c] = lanes[0] + lanes[1];
+    }
+#endif
+    for (; x < row.size(); ++x)
+    {
+        sums[0] += row[x].r;
+        sums[1] += row[x].g;
+        sums[2] += row[x].b;
+    }
+    return sums;
+}
+
+/**
+ * @brief Derives min, max, mean and variance of a channel from its histogram.
+ */
+ChannelStats channelStatsFromHistogram(const std::array<uint64_t, 256>& histogram, uint64_t count)
+{
+    ChannelStats stats{};
+    stats.histogram = histogram;
+    if (count == 0)
+    {
+        return stats;
+    }
+
+    int min = 0;
+    while (histogram[min] == 0)
+    {
+        ++min;
+    }
+    int max = 255;
+    while (histogram[max] == 0)
+    {
+        --max;
+    }
+
+    double sum = 0.0;
+    for (int v = min; v <= max; ++v)
+    {
+        sum += static_cast<double>(v) * histogram[v];
+    }
+    double mean = sum / count;
+
+    double squared_deviation = 0.0;
+    for (int v = min; v <= max; ++v)
+    {
+        squared_deviation += (v - mean) * (v - mean) * histogram[v];
+    }
+
+    stats.min = static_cast<uint8_t>(min);
+    stats.max = static_cast<uint8_t>(max);
+    stats.mean = mean;
+    stats.variance = squared_deviation / count;
+    return stats;
+}
+
+/**
+ * @brief Scales the channels of each pixel in a row so that its intensity becomes the target intensity.
+ */
+void scaleRowToIntensity(std::vector<Pixel>& row, const uint8_t* intensity, const float* target)
+{
+    for (size_t x = 0; x < row.size(); ++x)
+    {
+        Pixel& pixel = row[x];
+        if (intensity[x] == 0)
+        {
+            uint8_t value = static_cast<uint8_t>(std::clamp(target[x] + 0.5f, 0.0f, 255.0f));
+            pixel.r = pixel.g = pixel.b = value;
+            continue;
+        }
+        float gain = target[x] / intensity[x];
+        pixel.r = static_cast<uint8_t>(std::min(pixel.r * gain + 0.5f, 255.0f));
+        pixel.g = static_cast<uint8_t>(std::min(pixel.g * gain + 0.5f, 255.0f));
+        pixel.b = static_cast<uint8_t>(std::min(pixel.b * gain + 0.5f, 255.0f));
+    }
+}
+
+/**
+ * @brief Computes the intensity (mean of the three channels) of each pixel in a row.
+ */
+void rowIntensity(const std::vector<Pixel>& row, uint8_t* intensity)
+{
+    for (size_t x = 0; x < row.size(); ++x)
+    {
+        intensity[x] = static_cast<uint8_t>((row[x].r + row[x].g + row[x].b) / 3);
+    }
+}
+
+/**
+ * @brief Mirrors an index into [0, size) without repeating the edge element, like mirrorPadding.
+ */
+int reflectIndex(int i, int size)
+{
+    if (size == 1)
+    {
+        return 0;
+    }
+    while (i < 0 || i >= size)
+    {
+        i = (i < 0) ? -i : 2 * (size - 1) - i;
+    }
+    return i;
+}
+
+/**
+ * @brief Blurs a row of four-channel float pixels horizontally with a symmetric kernel.
+ * The kernel holds the center weight first; the padded row has kernel.size() - 1 extra pixels on each side.
+ */
+void blurRowHorizontal(const float* padded, float* out, int width, const std::vector<float>& kernel)
+{
+    int radius = static_cast<int>(kernel.size()) - 1;
+    for (int x = 0; x < width; ++x)
+    {
+        const float* center = padded + 4 * (x + radius);
+#ifdef __SSE2__
+        __m128 sum = _mm_mul_ps(_mm_set1_ps(kernel[0]), _mm_loadu_ps(center));
+        for (int i = 1; i <= radius; ++i)
+        {
+            __m128 pair = _mm_add_ps(_mm_loadu_ps(center - 4 * i), _mm_loadu_ps(center + 4 * i));
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel[i]), pair));
+        }
+        _mm_storeu_ps(out + 4 * x, sum);
+#else
+        for (int c = 0; c < 4; ++c)
+        {
+            float sum = kernel[0] * center[c];
+            for (int i = 1; i <= radius; ++i)
+            {
+                sum += kernel[i] * (center[c - 4 * i] + center[c + 4 * i]);
+            }
+            out[4 * x + c] = sum;
+        }
+#endif
+    }
+}
+
+/**
+ * @brief Blurs a row vertically from the horizontally blurred rows around it and applies the unsharp mask to it.
+ * rows holds the 2 * radius + 1 horizontally blurred rows from top to bottom. Channels whose difference to the
+ * blur is below the threshold are kept, the others move away from the blur by amount times the difference.
+ */
+void unsharpRow(const std::vector<const float*>& rows, const std::vector<float>& kernel, std::vector<Pixel>& row,
+                float amount, float threshold)
+{
+    int radius = static_cast<int>(kernel.size()) - 1;
+    const float* const* center = rows.data() + radius;
+#ifdef __SSE2__
+    const __m128 vamount = _mm_set1_ps(amount);
+    const __m128 vthreshold = _mm_set1_ps(threshold);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 color_lanes = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));  // leave alpha untouched
+    const __m128i zero = _mm_setzero_si128();
+#endif
+    for (size_t x = 0; x < row.size(); ++x)
+    {
+        size_t offset = 4 * x;
+#ifdef __SSE2__
+        __m128 blur = _mm_mul_ps(_mm_set1_ps(kernel[0]), _mm_loadu_ps(center[0] + offset));
+        for (int i = 1; i <= radius; ++i)
+        {
+            __m128 pair = _mm_add_ps(_mm_loadu_ps(center[-i] + offset), _mm_loadu_ps(center[i] + offset));
+            blur = _mm_add_ps(blur, _mm_mul_ps(_mm_set1_ps(kernel[i]), pair));
+        }
+
+        int32_t packed;
+        std::memcpy(&packed, &row[x], sizeof(packed));
+        __m128i words = _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero);
+        __m128 original = _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+        __m128 difference = _mm_sub_ps(original, blur);
+        __m128 mask = _mm_and_ps(_mm_cmpge_ps(_mm_andnot_ps(sign, difference), vthreshold), color_lanes);
+        __m128 value = _mm_add_ps(original, _mm_and_ps(mask, _mm_mul_ps(vamount, difference)));
+        value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+        __m128i result = _mm_cvtps_epi32(value);
+        result = _mm_packus_epi16(_mm_packs_epi32(result, zero), zero);
+        packed = _mm_cvtsi128_si32(result);
+        std::memcpy(&row[x], &packed, sizeof(packed));
+#else
+        uint8_t* channels = &row[x].r;
+        for (int c = 0; c < 3; ++c)
+        {
+            float blur = kernel[0] * center[0][offset + c];
+            for (int i = 1; i <= radius; ++i)
+            {
+                blur += kernel[i] * (center[-i][offset + c] + center[i][offset + c]);
+            }
+            float difference = channels[c] - blur;
+            if (std::fabs(difference) >= threshold)
+            {
+                channels[c] = static_cast<uint8_t>(std::clamp(std::nearbyint(channels[c] + amount * difference), 0.0f, 255.0f));
+            }
+        }
+#endif
+    }
+}
+
+/**
+ * @brief Computes the derivatives of one row from three rows of an intensity plane padded by one pixel.
+ * lower, center and upper are the padded rows below, at and above the output row; side and middle are the
+ * smoothing weights of the kernel.
+ */
+void gradientRow(const int16_t* lower, const int16_t* center, const int16_t* upper, int width, int16_t side,
+                 int16_t middle, int16_t* gx, int16_t* gy)
+{
+    int x = 0;
+#ifdef __SSE2__
+    const __m128i vside = _mm_set1_epi16(side);
+    const __m128i vmiddle = _mm_set1_epi16(middle);
+    auto load = [](const int16_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); };
+    for (; x + 8 <= width; x += 8)
+    {
+        __m128i dx_lower = _mm_sub_epi16(load(lower + x + 2), load(lower + x));
+        __m128i dx_center = _mm_sub_epi16(load(center + x + 2), load(center + x));
+        __m128i dx_upper = _mm_sub_epi16(load(upper + x + 2), load(upper + x));
+        __m128i dy_left = _mm_sub_epi16(load(upper + x), load(lower + x));
+        __m128i dy_middle = _mm_sub_epi16(load(upper + x + 1), load(lower + x + 1));
+        __m128i dy_right = _mm_sub_epi16(load(upper + x + 2), load(lower + x + 2));
+        __m128i dx = _mm_add_epi16(_mm_mullo_epi16(vside, _mm_add_epi16(dx_lower, dx_upper)), _mm_mullo_epi16(vmiddle, dx_center));
+        __m128i dy = _mm_add_epi16(_mm_mullo_epi16(vside, _mm_add_epi16(dy_left, dy_right)), _mm_mullo_epi16(vmiddle, dy_middle));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(gx + x), dx);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(gy + x), dy);
+    }
+#endif
+    for (; x < width; ++x)
+    {
+        gx[x] = static_cast<int16_t>(side * (lower[x + 2] - lower[x] + upper[x + 2] - upper[x]) + middle * (center[x + 2] - center[x]));
+        gy[x] = static_cast<int16_t>(side * (upper[x] - lower[x] + upper[x + 2] - lower[x + 2]) + middle * (upper[x + 1] - lower[x + 1]));
+    }
+}
+
+/**
+ * @brief Computes the Euclidean norm of a row of derivatives, multiplied by scale.
+ */
+void magnitudeRow(const int16_t* gx, const int16_t* gy, int width, float scale, float* magnitude)
+{
+    int x = 0;
+#ifdef __SSE2__
+    const __m128 vscale = _mm_set1_ps(scale);
+    for (; x + 8 <= width; x += 8)
+    {
+        __m128i dx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(gx + x));
+        __m128i dy = _mm_loadu_si128(reinterpret_cast<const __m128i*>(gy + x));
+        // Interleaving gx and gy lets one multiply-add produce gx * gx + gy * gy
+        __m128i low = _mm_unpacklo_epi16(dx, dy);
+        __m128i high = _mm_unpackhi_epi16(dx, dy);
+        __m128 low_norm = _mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(low, low)));
+        __m128 high_norm = _mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(high, high)));
+        _mm_storeu_ps(magnitude + x, _mm_mul_ps(low_norm, vscale));
+        _mm_storeu_ps(magnitude + x + 4, _mm_mul_ps(high_norm, vscale));
+    }
+#endif
+    for (; x < width; ++x)
+    {
+        magnitude[x] = std::sqrt(static_cast<float>(gx[x] * gx[x] + gy[x] * gy[x])) * scale;
+    }
+}
+}  // namespace
 
 BMPImage::BMPImage(const std::filesystem::path& filename)
 {
@@ -96,26 +425,240 @@ void BMPImage::write(const std::filesystem::path& filename)
     }
 }
 
-void BMPImage::adjustWhiteBalance()
+ImageStats BMPImage::stats(int row_stride) const
 {
-    // Calculate average values
-    long long total_r = 0, total_g = 0, total_b = 0;
+    using Histograms = std::array<std::array<uint64_t, 256>, 3>;
 
-    for (const auto& row : pixels)
+    if (row_stride < 1)
+    {
+        throw std::runtime_error("Row stride must be at least 1");
+    }
+
+    int sampled_rows = (info_header.height + row_stride - 1) / row_stride;
+    bool sampled = (row_stride > 1);
+
+    // Every thread fills its own histograms for a band of rows; sampled scans also keep the row sums. The histogram
+    // increments scatter to data-dependent bins, which SSE2 cannot do, so they stay scalar and the sums are vectorized.
+    int chunks = threadCount(sampled_rows);
+    std::vector<Histograms> partials(chunks);
+    std::vector<std::array<uint64_t, 3>> row_sums(sampled ? sampled_rows : 0);
+    parallelFor(sampled_rows, chunks, [&](int chunk, int begin, int end) {
+        Histograms histograms{};
+        for (int i = begin; i < end; ++i)
+        {
+            for (const auto& [r, g, b, a] : pixels[i * row_stride])
+            {
+                ++histograms[0][r];
+                ++histograms[1][g];
+                ++histograms[2][b];
+            }
+            if (sampled)
+            {
+                row_sums[i] = channelSums(pixels[i * row_stride]);
+            }
+        }
+        partials[chunk] = histograms;
+    });
+
+    // Merge in band order
+    Histograms merged{};
+    for (const auto& partial : partials)
     {
-        for (const auto& [r, g, b, a] : row)
+        for (int c = 0; c < 3; ++c)
         {
-            total_r += r;
-            total_g += g;
-            total_b += b;
+            for (int v = 0; v < 256; ++v)
+            {
+                merged[c][v] += partial[c][v];
+            }
         }
     }
 
-    int pixel_count = info_header.width * info_header.height;
+    ImageStats result;
+    result.pixel_count = static_cast<uint64_t>(info_header.width) * sampled_rows;
+    result.r = channelStatsFromHistogram(merged[0], result.pixel_count);
+    result.g = channelStatsFromHistogram(merged[1], result.pixel_count);
+    result.b = channelStatsFromHistogram(merged[2], result.pixel_count);
 
-    double avg_r = static_cast<double>(total_r) / pixel_count;
-    double avg_g = static_cast<double>(total_g) / pixel_count;
-    double avg_b = static_cast<double>(total_b) / pixel_count;
+    // Standard error of a systematic sample of rows, estimated from successive differences of the
+    // row means (so smooth gradients across the image do not inflate it), with the finite population correction
+    if (sampled && sampled_rows > 1 && info_header.width > 0)
+    {
+        ChannelStats* channels[3] = { &result.r, &result.g, &result.b };
+        double correction = 1.0 - static_cast<double>(sampled_rows) / info_header.height;
+        for (int c = 0; c < 3; ++c)
+        {
+            double squared_difference = 0.0;
+            for (int i = 1; i < sampled_rows; ++i)
+            {
+                double difference = (static_cast<double>(row_sums[i][c]) - static_cast<double>(row_sums[i - 1][c])) / info_header.width;
+                squared_difference += difference * difference;
+            }
+            double row_variance = squared_difference / (2.0 * (sampled_rows - 1));
+            channels[c]->mean_error = std::sqrt(row_variance / sampled_rows * correction);
+        }
+    }
+
+    return result;
+}
+
+void BMPImage::applyLUT(const std::array<uint8_t, 256>& r_lut, const std::array<uint8_t, 256>& g_lut, const std::array<uint8_t, 256>& b_lut)
+{
+    parallelFor(info_header.height, threadCount(info_header.height), [&](int, int begin, int end) {
+        for (int y = begin; y < end; ++y)
+        {
+            for (auto& [r, g, b, a] : pixels[y])
+            {
+                r = r_lut[r];
+                g = g_lut[g];
+                b = b_lut[b];
+            }
+        }
+    });
+}
+
+void BMPImage::adjustWhiteBalance(int row_stride, double max_error)
+{
+    // Calculate average values, from every row if the sampled estimate is not accurate enough
+    ImageStats image_stats = stats(row_stride);
+    if (row_stride > 1 && 3 * std::max({ image_stats.r.mean_error, image_stats.g.mean_error, image_stats.b.mean_error }) > max_error)
+    {
+        image_stats = stats();
+    }
+
+    applyWhiteBalance({ image_stats.r.mean, image_stats.g.mean, image_stats.b.mean });
+}
+
+IlluminantEstimates BMPImage::estimateIlluminants(double percentile, double p, double edge_p) const
+{
+    if (percentile <= 0 || percentile > 100 || p <= 0 || edge_p <= 0)
+    {
+        throw std::runtime_error("Percentile must be in (0, 100] and norms must be greater than 0");
+    }
+
+    // The gradient magnitude of 8-bit channels is at most sqrt(2) * 255
+    constexpr int EDGE_BINS = 362;
+    struct Histograms
+    {
+        std::array<std::array<uint64_t, 256>, 3> value;
+        std::array<std::array<uint64_t, EDGE_BINS>, 3> edge;
+    };
+
+    int width = info_header.width;
+    int height = info_header.height;
+
+    // One fused pass: value histograms for every pixel, gradient histograms wherever both forward differences exist
+    int chunks = threadCount(height);
+    std::vector<Histograms> partials(chunks);
+    parallelFor(height, chunks, [&](int chunk, int begin, int end) {
+        Histograms& histograms = partials[chunk];
+        histograms = {};
+        for (int y = begin; y < end; ++y)
+        {
+            const std::vector<Pixel>& row = pixels[y];
+            for (const auto& [r, g, b, a] : row)
+            {
+                ++histograms.value[0][r];
+                ++histograms.value[1][g];
+                ++histograms.value[2][b];
+            }
+            if (y + 1 >= height)
+            {
+                continue;
+            }
+            const std::vector<Pixel>& next_row = pixels[y + 1];
+            for (int x = 0; x + 1 < width; ++x)
+            {
+                const uint8_t* here = &row[x].r;
+                const uint8_t* right = &row[x + 1].r;
+                const uint8_t* above = &next_row[x].r;
+                for (int c = 0; c < 3; ++c)
+                {
+                    float dx = static_cast<float>(right[c] - here[c]);
+                    float dy = static_cast<float>(above[c] - here[c]);
+                    ++histograms.edge[c][static_cast<int>(std::sqrt(dx * dx + dy * dy) + 0.5f)];
+                }
+            }
+        }
+    });
+
+    // Merge in band order
+    Histograms merged{};
+    for (const auto& partial : partials)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            for (int v = 0; v < 256; ++v)
+            {
+                merged.value[c][v] += partial.value[c][v];
+            }
+            for (int m = 0; m < EDGE_BINS; ++m)
+            {
+                merged.edge[c][m] += partial.edge[c][m];
+            }
+        }
+    }
+
+    // Minkowski norm of a histogram
+    auto minkowski = [](const auto& histogram, double norm) {
+        double sum = 0.0;
+        uint64_t count = 0;
+        for (size_t v = 0; v < histogram.size(); ++v)
+        {
+            sum += std::pow(static_cast<double>(v), norm) * histogram[v];
+            count += histogram[v];
+        }
+        return (count == 0) ? 0.0 : std::pow(sum / count, 1.0 / norm);
+    };
+
+    uint64_t pixel_count = static_cast<uint64_t>(width) * height;
+    uint64_t percentile_count = static_cast<uint64_t>(std::ceil(pixel_count * percentile / 100.0));
+
+    IlluminantEstimates estimates;
+    for (int c = 0; c < 3; ++c)
+    {
+        const auto& histogram = merged.value[c];
+        estimates.gray_world[c] = channelStatsFromHistogram(histogram, pixel_count).mean;
+        estimates.shades_of_gray[c] = minkowski(histogram, p);
+        estimates.gray_edge[c] = minkowski(merged.edge[c], edge_p);
+
+        int v = 0;
+        uint64_t cumulative = histogram[0];
+        while (v < 255 && cumulative < percentile_count)
+        {
+            cumulative += histogram[++v];
+        }
+        estimates.white_patch[c] = v;
+    }
+    return estimates;
+}
+
+void BMPImage::adjustWhiteBalance(WhiteBalanceMethod method)
+{
+    IlluminantEstimates estimates = estimateIlluminants();
+    switch (method)
+    {
+        case WhiteBalanceMethod::GrayWorld:
+            applyWhiteBalance(estimates.gray_world);
+            break;
+        case WhiteBalanceMethod::WhitePatch:
+            applyWhiteBalance(estimates.white_patch);
+            break;
+        case WhiteBalanceMethod::ShadesOfGray:
+            applyWhiteBalance(estimates.shades_of_gray);
+            break;
+        case WhiteBalanceMethod::GrayEdge:
+            applyWhiteBalance(estimates.gray_edge);
+            break;
+    }
+}
+
+void BMPImage::applyWhiteBalance(const std::array<double, 3>& illuminant)
+{
+    const auto& [avg_r, avg_g, avg_b] = illuminant;
+    if (avg_r <= 0 || avg_g <= 0 || avg_b <= 0)
+    {
+        throw std::runtime_error("Illuminant channels must be greater than 0");
+    }
 
     // Compute adjustment factors
     double avg_grey = (avg_r + avg_g + avg_b) / 3;
@@ -123,16 +666,50 @@ void BMPImage::adjustWhiteBalance()
     double g_factor = avg_grey / avg_g;
     double b_factor = avg_grey / avg_b;
 
-    // Adjust pixels
-    for (auto& row : pixels)
+    // Adjust pixels through one table per channel
+    std::array<uint8_t, 256> r_lut, g_lut, b_lut;
+    for (int v = 0; v < 256; ++v)
     {
-        for (auto& [r, g, b, a] : row)
+        r_lut[v] = std::clamp(static_cast<int>(v * r_factor), 0, 255);
+        g_lut[v] = std::clamp(static_cast<int>(v * g_factor), 0, 255);
+        b_lut[v] = std::clamp(static_cast<int>(v * b_factor), 0, 255);
+    }
+    applyLUT(r_lut, g_lut, b_lut);
+}
+
+void BMPImage::autoContrast(double clip_percent)
+{
+    if (clip_percent < 0 || clip_percent >= 50)
+    {
+        throw std::runtime_error("Clip percentage must be in [0, 50)");
+    }
+
+    ImageStats image_stats = stats();
+    uint64_t clip_count = static_cast<uint64_t>(image_stats.pixel_count * clip_percent / 100.0);
+
+    // Build a stretching table for each channel from its clipped histogram range
+    auto stretch_lut = [clip_count](const ChannelStats& channel) {
+        std::array<uint8_t, 256> lut;
+        int low = 0;
+        uint64_t below = channel.histogram[0];
+        while (low < 255 && below <= clip_count)
         {
-            r = std::clamp(static_cast<int>(r * r_factor), 0, 255);
-            g = std::clamp(static_cast<int>(g * g_factor), 0, 255);
-            b = std::clamp(static_cast<int>(b * b_factor), 0, 255);
+            below += channel.histogram[++low];
         }
-    }
+        int high = 255;
+        uint64_t above = channel.histogram[255];
+        while (high > 0 && above <= clip_count)
+        {
+            above += channel.histogram[--high];
+        }
+        for (int v = 0; v < 256; ++v)
+        {
+            lut[v] = (high > low) ? static_cast<uint8_t>(std::clamp((v - low) * 255 / (high - low), 0, 255)) : static_cast<uint8_t>(v);
+        }
+        return lut;
+    };
+
+    applyLUT(stretch_lut(image_stats.r), stretch_lut(image_stats.g), stretch_lut(image_stats.b));
 }
 
 std::vector<std::vector<Pixel>> BMPImage::mirrorPadding(const std::vector<std::vector<Pixel>>& original_pixels, int edge)
@@ -209,6 +786,289 @@ void BMPImage::sharpen(double sharpness)
     }
 }
 
+void BMPImage::unsharpMask(double radius, double amount, int threshold)
+{
+    if (radius <= 0)
+    {
+        throw std::runtime_error("Unsharp mask radius must be greater than 0");
+    }
+    if (threshold < 0 || threshold > 255)
+    {
+        throw std::runtime_error("Unsharp mask threshold must be between 0 and 255");
+    }
+
+    int width = info_header.width;
+    int height = info_header.height;
+
+    // Half of the normalized Gaussian kernel, center weight first
+    int kernel_radius = static_cast<int>(std::ceil(3.0 * radius));
+    std::vector<float> kernel(kernel_radius + 1);
+    double kernel_sum = 0.0;
+    for (int i = 0; i <= kernel_radius; ++i)
+    {
+        double weight = std::exp(-(i * i) / (2.0 * radius * radius));
+        kernel[i] = static_cast<float>(weight);
+        kernel_sum += (i == 0) ? weight : 2.0 * weight;
+    }
+    for (float& weight : kernel)
+    {
+        weight = static_cast<float>(weight / kernel_sum);
+    }
+
+    std::vector<int> source_x(width + 2 * kernel_radius);
+    for (int x = 0; x < static_cast<int>(source_x.size()); ++x)
+    {
+        source_x[x] = reflectIndex(x - kernel_radius, width);
+    }
+
+    // Each band of rows is sharpened in place, so the rows it needs from outside (and the mirrored rows
+    // past the image border) are copied before any band starts writing.
+    int chunks = threadCount(height);
+    std::vector<std::vector<std::vector<Pixel>>> halos(chunks);
+    for (int chunk = 0; chunk < chunks; ++chunk)
+    {
+        int begin = chunkBegin(height, chunks, chunk);
+        int end = chunkBegin(height, chunks, chunk + 1);
+        for (int y = begin - kernel_radius; y < begin; ++y)
+        {
+            halos[chunk].push_back(pixels[reflectIndex(y, height)]);
+        }
+        for (int y = end; y < end + kernel_radius; ++y)
+        {
+            halos[chunk].push_back(pixels[reflectIndex(y, height)]);
+        }
+    }
+
+    int window = 2 * kernel_radius + 1;
+    size_t row_size = static_cast<size_t>(width) * 4;
+    parallelFor(height, chunks, [&](int chunk, int begin, int end) {
+        // Ring of horizontally blurred rows; only the rows inside the vertical window are kept
+        std::vector<float> ring(row_size * window);
+        std::vector<float> padded(source_x.size() * 4);
+        auto ring_row = [&](int y) { return &ring[static_cast<size_t>(((y % window) + window) % window) * row_size]; };
+        auto blur_row = [&](int y) {
+            const std::vector<Pixel>& source =
+                (y < begin) ? halos[chunk][y - (begin - kernel_radius)] : (y >= end) ? halos[chunk][kernel_radius + y - end] : pixels[y];
+            for (size_t x = 0; x < source_x.size(); ++x)
+            {
+                const Pixel& pixel = source[source_x[x]];
+                padded[4 * x] = pixel.r;
+                padded[4 * x + 1] = pixel.g;
+                padded[4 * x + 2] = pixel.b;
+                padded[4 * x + 3] = pixel.a;
+            }
+            blurRowHorizontal(padded.data(), ring_row(y), width, kernel);
+        };
+
+        for (int y = begin - kernel_radius; y < begin + kernel_radius; ++y)
+        {
+            blur_row(y);
+        }
+        std::vector<const float*> rows(window);
+        for (int y = begin; y < end; ++y)
+        {
+            blur_row(y + kernel_radius);
+            for (int i = 0; i < window; ++i)
+            {
+                rows[i] = ring_row(y - kernel_radius + i);
+            }
+            unsharpRow(rows, kernel, pixels[y], static_cast<float>(amount), static_cast<float>(threshold));
+        }
+    });
+}
+
+GradientField BMPImage::gradient(GradientOperator op, bool with_direction) const
+{
+    int width = info_header.width;
+    int height = info_header.height;
+    int16_t side = (op == GradientOperator::Scharr) ? 3 : 1;
+    int16_t middle = (op == GradientOperator::Scharr) ? 10 : 2;
+    float scale = 1.0f / (2 * side + middle);
+
+    // Intensity plane padded by one mirrored pixel, as mirrorPadding does for sharpen
+    int padded_width = width + 2;
+    std::vector<int16_t> plane(static_cast<size_t>(padded_width) * (height + 2));
+    std::vector<int> source_x(padded_width);
+    for (int x = 0; x < padded_width; ++x)
+    {
+        source_x[x] = reflectIndex(x - 1, width);
+    }
+    for (int y = 0; y < height + 2; ++y)
+    {
+        const std::vector<Pixel>& row = pixels[reflectIndex(y - 1, height)];
+        int16_t* out = &plane[static_cast<size_t>(y) * padded_width];
+        for (int x = 0; x < padded_width; ++x)
+        {
+            const Pixel& pixel = row[source_x[x]];
+            out[x] = static_cast<int16_t>((pixel.r + pixel.g + pixel.b) / 3);
+        }
+    }
+
+    GradientField field;
+    field.width = width;
+    field.height = height;
+    size_t size = static_cast<size_t>(width) * height;
+    field.gx.resize(size);
+    field.gy.resize(size);
+    field.magnitude.resize(size);
+    if (with_direction)
+    {
+        field.direction.resize(size);
+    }
+    parallelFor(height, threadCount(height), [&](int, int begin, int end) {
+        for (int y = begin; y < end; ++y)
+        {
+            const int16_t* lower = &plane[static_cast<size_t>(y) * padded_width];
+            size_t offset = static_cast<size_t>(y) * width;
+            gradientRow(lower, lower + padded_width, lower + 2 * padded_width, width, side, middle, &field.gx[offset], &field.gy[offset]);
+            magnitudeRow(&field.gx[offset], &field.gy[offset], width, scale, &field.magnitude[offset]);
+            for (int x = 0; with_direction && x < width; ++x)
+            {
+                field.direction[offset + x] = std::atan2(static_cast<float>(field.gy[offset + x]), static_cast<float>(field.gx[offset + x]));
+            }
+        }
+    });
+    return field;
+}
+
+void BMPImage::applyGradientMagnitude(GradientOperator op)
+{
+    GradientField field = gradient(op, false);
+    for (int y = 0; y < info_header.height; ++y)
+    {
+        const float* magnitude = &field.magnitude[static_cast<size_t>(y) * field.width];
+        for (int x = 0; x < info_header.width; ++x)
+        {
+            uint8_t value = static_cast<uint8_t>(std::min(magnitude[x] + 0.5f, 255.0f));
+            pixels[y][x].r = pixels[y][x].g = pixels[y][x].b = value;
+        }
+    }
+}
+
+std::vector<uint8_t> BMPImage::canny(double low_threshold, double high_threshold, GradientOperator op) const
+{
+    if (low_threshold < 0 || high_threshold < low_threshold)
+    {
+        throw std::runtime_error("Canny thresholds must satisfy 0 <= low <= high");
+    }
+
+    GradientField field = gradient(op, false);
+    int width = field.width;
+    int height = field.height;
+    float low = static_cast<float>(low_threshold);
+    float high = static_cast<float>(high_threshold);
+
+    // Non-maximum suppression. The direction is quantized to four sectors by comparing |gy| with
+    // |gx| * tan(22.5 deg) and |gx| * tan(67.5 deg). Candidates are 1 (weak) or 2 (strong); the state
+    // plane has a border of zeros so that the hysteresis needs no bounds checks.
+    const float tan_22_5 = 0.41421356f;
+    const float tan_67_5 = 2.41421356f;
+    int stride = width + 2;
+    std::vector<uint8_t> state(static_cast<size_t>(stride) * (height + 2), 0);
+    parallelFor(height, threadCount(height), [&](int, int begin, int end) {
+        for (int y = begin; y < end; ++y)
+        {
+            const float* magnitude = &field.magnitude[static_cast<size_t>(y) * width];
+            const int16_t* gx = &field.gx[static_cast<size_t>(y) * width];
+            const int16_t* gy = &field.gy[static_cast<size_t>(y) * width];
+            uint8_t* out = &state[static_cast<size_t>(y + 1) * stride + 1];
+            bool border_row = (y == 0 || y == height - 1);
+            for (int x = 0; x < width; ++x)
+            {
+                if (magnitude[x] <= low)
+                {
+                    continue;
+                }
+                float ax = std::abs(static_cast<float>(gx[x]));
+                float ay = std::abs(static_cast<float>(gy[x]));
+                int dx = 1, dy = 0;
+                if (ay >= ax * tan_67_5)
+                {
+                    dx = 0, dy = 1;
+                }
+                else if (ay > ax * tan_22_5)
+                {
+                    dy = ((gx[x] < 0) == (gy[x] < 0)) ? 1 : -1;
+                }
+
+                float before, after;
+                if (border_row || x == 0 || x == width - 1)
+                {
+                    // Neighbors outside the image count as zero magnitude
+                    auto magnitude_at = [&](int nx, int ny) {
+                        return (nx < 0 || nx >= width || ny < 0 || ny >= height) ? 0.0f : field.magnitude[static_cast<size_t>(ny) * width + nx];
+                    };
+                    before = magnitude_at(x - dx, y - dy);
+                    after = magnitude_at(x + dx, y + dy);
+                }
+                else
+                {
+                    std::ptrdiff_t step = static_cast<std::ptrdiff_t>(dy) * width + dx;
+                    before = magnitude[x - step];
+                    after = magnitude[x + step];
+                }
+                // Ties are broken towards one side so that plateaus keep a single pixel
+                if (magnitude[x] > before && magnitude[x] >= after)
+                {
+                    out[x] = (magnitude[x] > high) ? 2 : 1;
+                }
+            }
+        }
+    });
+
+    // Hysteresis: grow every strong pixel through the 8-connected candidates, marking the edges with 3
+    const std::ptrdiff_t neighbors[8] = { -stride - 1, -stride, -stride + 1, -1, 1, stride - 1, stride, stride + 1 };
+    std::vector<size_t> stack;
+    for (size_t seed = 0; seed < state.size(); ++seed)
+    {
+        if (state[seed] != 2)
+        {
+            continue;
+        }
+        state[seed] = 3;
+        stack.push_back(seed);
+        while (!stack.empty())
+        {
+            size_t index = stack.back();
+            stack.pop_back();
+            for (std::ptrdiff_t offset : neighbors)
+            {
+                size_t neighbor = index + offset;
+                if (state[neighbor] == 1 || state[neighbor] == 2)
+                {
+                    state[neighbor] = 3;
+                    stack.push_back(neighbor);
+                }
+            }
+        }
+    }
+
+    std::vector<uint8_t> edges(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t* marks = &state[static_cast<size_t>(y + 1) * stride + 1];
+        uint8_t* out = &edges[static_cast<size_t>(y) * width];
+        for (int x = 0; x < width; ++x)
+        {
+            out[x] = (marks[x] == 3) ? 255 : 0;
+        }
+    }
+    return edges;
+}
+
+void BMPImage::applyCanny(double low_threshold, double high_threshold, GradientOperator op)
+{
+    std::vector<uint8_t> edges = canny(low_threshold, high_threshold, op);
+    for (int y = 0; y < info_header.height; ++y)
+    {
+        const uint8_t* edge = &edges[static_cast<size_t>(y) * info_header.width];
+        for (int x = 0; x < info_header.width; ++x)
+        {
+            pixels[y][x].r = pixels[y][x].g = pixels[y][x].b = edge[x];
+        }
+    }
+}
+
 void BMPImage::RGBtoHSV(double r, double g, double b, double& h, double& s, double& v)
 {
     r = r / 255.0;
@@ -443,3 +1303,202 @@ void BMPImage::adjustContrast(double contrastFactor)
         }
     }
 }
+
+void BMPImage::equalizeHistogram()
+{
+    int width = info_header.width;
+    int height = info_header.height;
+    if (width == 0 || height == 0)
+    {
+        return;
+    }
+
+    // Intensity plane and its histogram, one partial histogram per band of rows
+    std::vector<uint8_t> intensity(static_cast<size_t>(width) * height);
+    int chunks = threadCount(height);
+    std::vector<std::array<uint64_t, 256>> partials(chunks);
+    parallelFor(height, chunks, [&](int chunk, int begin, int end) {
+        std::array<uint64_t, 256> histogram{};
+        for (int y = begin; y < end; ++y)
+        {
+            uint8_t* row_intensity = &intensity[static_cast<size_t>(y) * width];
+            rowIntensity(pixels[y], row_intensity);
+            for (int x = 0; x < width; ++x)
+            {
+                ++histogram[row_intensity[x]];
+            }
+        }
+        partials[chunk] = histogram;
+    });
+
+    std::array<uint64_t, 256> histogram{};
+    for (const auto& partial : partials)
+    {
+        for (int v = 0; v < 256; ++v)
+        {
+            histogram[v] += partial[v];
+        }
+    }
+
+    // Normalized cumulative histogram
+    uint64_t pixel_count = static_cast<uint64_t>(width) * height;
+    uint64_t cdf_min = 0;
+    for (int v = 0; v < 256 && cdf_min == 0; ++v)
+    {
+        cdf_min = histogram[v];
+    }
+    std::array<float, 256> lut;
+    uint64_t cdf = 0;
+    for (int v = 0; v < 256; ++v)
+    {
+        cdf += histogram[v];
+        lut[v] = (pixel_count == cdf_min) ? static_cast<float>(v) : 255.0f * (cdf - std::min(cdf, cdf_min)) / (pixel_count - cdf_min);
+    }
+
+    parallelFor(height, chunks, [&](int, int begin, int end) {
+        std::vector<float> target(width);
+        for (int y = begin; y < end; ++y)
+        {
+            const uint8_t* row_intensity = &intensity[static_cast<size_t>(y) * width];
+            for (int x = 0; x < width; ++x)
+            {
+                target[x] = lut[row_intensity[x]];
+            }
+            scaleRowToIntensity(pixels[y], row_intensity, target.data());
+        }
+    });
+}
+
+void BMPImage::applyCLAHE(int tiles_x, int tiles_y, double clip_limit)
+{
+    int width = info_header.width;
+    int height = info_header.height;
+    if (tiles_x < 1 || tiles_y < 1 || tiles_x > width || tiles_y > height)
+    {
+        throw std::runtime_error("Tile counts must be between 1 and the image size");
+    }
+
+    // Intensity plane
+    std::vector<uint8_t> intensity(static_cast<size_t>(width) * height);
+    parallelFor(height, threadCount(height), [&](int, int begin, int end) {
+        for (int y = begin; y < end; ++y)
+        {
+            rowIntensity(pixels[y], &intensity[static_cast<size_t>(y) * width]);
+        }
+    });
+
+    // Tile boundaries and centers
+    auto boundaries = [](int size, int tiles) {
+        std::vector<int> bounds(tiles + 1);
+        for (int t = 0; t <= tiles; ++t)
+        {
+            bounds[t] = static_cast<int>(static_cast<long long>(size) * t / tiles);
+        }
+        return bounds;
+    };
+    std::vector<int> x_bounds = boundaries(width, tiles_x);
+    std::vector<int> y_bounds = boundaries(height, tiles_y);
+
+    // Clipped and redistributed mapping of every tile, computed in parallel
+    int tile_count = tiles_x * tiles_y;
+    std::vector<std::array<float, 256>> luts(tile_count);
+    parallelFor(tile_count, threadCount(tile_count), [&](int, int begin, int end) {
+        for (int tile = begin; tile < end; ++tile)
+        {
+            int tx = tile % tiles_x;
+            int ty = tile / tiles_x;
+            std::array<uint32_t, 256> histogram{};
+            for (int y = y_bounds[ty]; y < y_bounds[ty + 1]; ++y)
+            {
+                const uint8_t* row_intensity = &intensity[static_cast<size_t>(y) * width];
+                for (int x = x_bounds[tx]; x < x_bounds[tx + 1]; ++x)
+                {
+                    ++histogram[row_intensity[x]];
+                }
+            }
+
+            uint32_t tile_pixels = (x_bounds[tx + 1] - x_bounds[tx]) * (y_bounds[ty + 1] - y_bounds[ty]);
+            if (clip_limit > 0)
+            {
+                uint32_t limit = std::max<uint32_t>(1, static_cast<uint32_t>(clip_limit * tile_pixels / 256));
+                uint32_t excess = 0;
+                for (auto& count : histogram)
+                {
+                    if (count > limit)
+                    {
+                        excess += count - limit;
+                        count = limit;
+                    }
+                }
+                uint32_t share = excess / 256;
+                uint32_t remainder = excess % 256;
+                for (int v = 0; v < 256; ++v)
+                {
+                    histogram[v] += share + (static_cast<uint32_t>(v) < remainder ? 1 : 0);
+                }
+            }
+
+            uint32_t cdf = 0;
+            for (int v = 0; v < 256; ++v)
+            {
+                cdf += histogram[v];
+                luts[tile][v] = 255.0f * cdf / tile_pixels;
+            }
+        }
+    });
+
+    // Neighboring tiles and interpolation weight of every column, shared by all rows
+    auto interpolation = [](const std::vector<int>& bounds, int size, std::vector<int>& first, std::vector<float>& weight) {
+        int tiles = static_cast<int>(bounds.size()) - 1;
+        first.resize(size);
+        weight.resize(size);
+        int t = 0;
+        for (int i = 0; i < size; ++i)
+        {
+            while (t + 1 < tiles && i >= (bounds[t + 1] + bounds[t + 2] - 1) / 2.0f)
+            {
+                ++t;
+            }
+            float center = (bounds[t] + bounds[t + 1] - 1) / 2.0f;
+            float next_center = (t + 1 < tiles) ? (bounds[t + 1] + bounds[t + 2] - 1) / 2.0f : center;
+            first[i] = t;
+            weight[i] = (next_center > center) ? std::clamp((i - center) / (next_center - center), 0.0f, 1.0f) : 0.0f;
+        }
+    };
+    std::vector<int> x_tile, y_tile;
+    std::vector<float> x_weight, y_weight;
+    interpolation(x_bounds, width, x_tile, x_weight);
+    interpolation(y_bounds, height, y_tile, y_weight);
+
+    // Bilinear blending of the four surrounding tile mappings. The table lookups are gathered into
+    // contiguous rows first so that the blending loop itself is vectorized.
+    parallelFor(height, threadCount(height), [&](int, int begin, int end) {
+        std::vector<float> top_left(width), top_right(width), bottom_left(width), bottom_right(width), target(width);
+        for (int y = begin; y < end; ++y)
+        {
+            const uint8_t* row_intensity = &intensity[static_cast<size_t>(y) * width];
+            int ty0 = y_tile[y];
+            int ty1 = std::min(ty0 + 1, tiles_y - 1);
+            for (int x = 0; x < width; ++x)
+            {
+                int tx0 = x_tile[x];
+                int tx1 = std::min(tx0 + 1, tiles_x - 1);
+                uint8_t v = row_intensity[x];
+                top_left[x] = luts[ty0 * tiles_x + tx0][v];
+                top_right[x] = luts[ty0 * tiles_x + tx1][v];
+                bottom_left[x] = luts[ty1 * tiles_x + tx0][v];
+                bottom_right[x] = luts[ty1 * tiles_x + tx1][v];
+            }
+
+            float wy = y_weight[y];
+            const float* wx = x_weight.data();
+            for (int x = 0; x < width; ++x)
+            {
+                float upper = top_left[x] + wx[x] * (top_right[x] - top_left[x]);
+                float lower = bottom_left[x] + wx[x] * (bottom_right[x] - bottom_left[x]);
+                target[x] = upper + wy * (lower - upper);
+            }
+            scaleRowToIntensity(pixels[y], row_intensity, target.data());
+        }
+    });
+}
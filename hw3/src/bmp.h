@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <array>
 #include <filesystem>
 #include <stdint.h>
 #include <vector>
@@ -99,6 +100,101 @@ struct Pixel
     uint8_t r, g, b, a;
 };
 
+/**
+ * @brief The ChannelStats struct holds the statistics of one color channel.
+ * The ChannelStats struct contains the following fields:
+ * - min: the smallest value of the channel
+ * - max: the largest value of the channel
+ * - mean: the mean value of the channel
+ * - variance: the population variance of the channel
+ * - mean_error: the estimated standard error of the mean (0 when every row was scanned)
+ * - histogram: the number of pixels for each of the 256 values
+ *
+ */
+struct ChannelStats
+{
+    uint8_t min;
+    uint8_t max;
+    double mean;
+    double variance;
+    double mean_error;
+    std::array<uint64_t, 256> histogram;
+};
+
+/**
+ * @brief The ImageStats struct holds the per-channel statistics of an image.
+ * The channels follow the field order of the Pixel struct, and pixel_count is the number of pixels scanned.
+ *
+ */
+struct ImageStats
+{
+    ChannelStats r, g, b;
+    uint64_t pixel_count;
+};
+
+/**
+ * @brief The WhiteBalanceMethod enum selects how the illuminant color is estimated.
+ * - GrayWorld: the mean of each channel
+ * - WhitePatch: a high percentile of each channel (a robust maximum)
+ * - ShadesOfGray: the Minkowski p-norm of each channel
+ * - GrayEdge: the Minkowski p-norm of the gradient magnitude of each channel
+ *
+ */
+enum class WhiteBalanceMethod
+{
+    GrayWorld,
+    WhitePatch,
+    ShadesOfGray,
+    GrayEdge
+};
+
+/**
+ * @brief The IlluminantEstimates struct holds the illuminant color estimated by every WhiteBalanceMethod.
+ * Each estimate lists the channels in the field order of the Pixel struct.
+ *
+ */
+struct IlluminantEstimates
+{
+    std::array<double, 3> gray_world;
+    std::array<double, 3> white_patch;
+    std::array<double, 3> shades_of_gray;
+    std::array<double, 3> gray_edge;
+};
+
+/**
+ * @brief The GradientOperator enum selects the 3x3 derivative kernel.
+ * - Sobel: smoothing weights 1, 2, 1
+ * - Scharr: smoothing weights 3, 10, 3, which are closer to rotation invariant
+ *
+ */
+enum class GradientOperator
+{
+    Sobel,
+    Scharr
+};
+
+/**
+ * @brief The GradientField struct holds the intensity gradient of an image.
+ * The GradientField struct contains the following fields, each stored row by row in the row order of the image:
+ * - width: the width of the field
+ * - height: the height of the field
+ * - gx: the horizontal derivative (positive when the intensity increases to the right)
+ * - gy: the vertical derivative (positive when the intensity increases upwards)
+ * - magnitude: the Euclidean norm of the derivatives, divided by the kernel weight so that a step of
+ *   height h between flat regions has magnitude h
+ * - direction: the angle of the gradient in radians, counterclockwise from the +x axis, in [-pi, pi]
+ *
+ */
+struct GradientField
+{
+    int width;
+    int height;
+    std::vector<int16_t> gx;
+    std::vector<int16_t> gy;
+    std::vector<float> magnitude;
+    std::vector<float> direction;
+};
+
 /**
  * @brief A class representing a BMP (Bitmap) image with various operations for manipulation and I/O.
  *
@@ -112,6 +208,15 @@ class BMPImage
     BMPInfoHeader info_header;
     std::vector<std::vector<Pixel>> pixels;
 
+    /**
+     * @brief Maps the red, green and blue channels of every pixel through lookup tables.
+     *
+     * @param r_lut The lookup table of the red channel.
+     * @param g_lut The lookup table of the green channel.
+     * @param b_lut The lookup table of the blue channel.
+     */
+    void applyLUT(const std::array<uint8_t, 256>& r_lut, const std::array<uint8_t, 256>& g_lut, const std::array<uint8_t, 256>& b_lut);
+
   public:
     /**
      * @brief Construct a new BMPImage object
@@ -134,12 +239,65 @@ class BMPImage
      */
     void write(const std::filesystem::path& filename);
 
+    /**
+     * @brief Computes the per-channel statistics of the image in a single pass.
+     * Each thread builds histograms for a band of rows; the histograms are merged in band order
+     * and min, max, mean and variance are derived from them, so the result does not depend on
+     * the number of threads.
+     * With a row stride above 1 only every row_stride-th row is scanned, and the error of each mean is
+     * estimated from the differences between the means of successive sampled rows.
+     *
+     * @param row_stride The distance between scanned rows.
+     * @return The statistics of the red, green and blue channels.
+     */
+    ImageStats stats(int row_stride = 1) const;
+
     /**
      * @brief Adjusts the white balance of the image using grep world method.
      * White balance adjustment can help correct color tints in an image
      * caused by different light sources.
+     * The channel means can be estimated from every row_stride-th row. If three standard errors of any
+     * estimated mean exceed max_error, the means are recomputed from every row. The gains are then
+     * applied through one lookup table per channel.
+     *
+     * @param row_stride The distance between rows used to estimate the channel means.
+     * @param max_error The largest accepted error of a sampled channel mean, in gray levels.
      */
-    void adjustWhiteBalance();
+    void adjustWhiteBalance(int row_stride = 1, double max_error = 2.0);
+
+    /**
+     * @brief Estimates the illuminant color with every WhiteBalanceMethod in a single pass.
+     * One pass fills the value histogram and the gradient magnitude histogram of each channel
+     * (forward differences); all estimates are then computed from the histograms.
+     *
+     * @param percentile The percentile used by the white-patch estimate.
+     * @param p The Minkowski norm used by the shades-of-gray estimate.
+     * @param edge_p The Minkowski norm used by the gray-edge estimate.
+     * @return The illuminant estimates.
+     */
+    IlluminantEstimates estimateIlluminants(double percentile = 99.0, double p = 6.0, double edge_p = 6.0) const;
+
+    /**
+     * @brief Adjusts the white balance of the image with the illuminant from the selected estimator.
+     *
+     * @param method The illuminant estimator.
+     */
+    void adjustWhiteBalance(WhiteBalanceMethod method);
+
+    /**
+     * @brief Scales each channel so that the given illuminant becomes neutral gray.
+     * The gains keep the average of the illuminant channels and are applied through lookup tables.
+     *
+     * @param illuminant The illuminant color, in the field order of the Pixel struct.
+     */
+    void applyWhiteBalance(const std::array<double, 3>& illuminant);
+
+    /**
+     * @brief Stretches each channel so that its histogram covers the full range.
+     *
+     * @param clip_percent The percentage of pixels to saturate at each end of the histogram.
+     */
+    void autoContrast(double clip_percent);
 
     /**
      * @brief Mirrors the image by adding padding to the edges.
@@ -166,6 +324,59 @@ class BMPImage
      */
     void sharpen(double sharpness);
 
+    /**
+     * @brief Sharpens the image with an unsharp mask.
+     * The image is blurred with a separable Gaussian, and every channel that differs from the blur by at
+     * least the threshold is pushed away from it by amount times the difference. The blur is streamed
+     * through a ring of horizontally blurred rows and combined with the image in the same pass, so no
+     * blurred copy of the image is kept. The borders are mirrored.
+     *
+     * @param radius The standard deviation of the Gaussian blur in pixels; it selects the scale of the enhanced detail.
+     * @param amount The strength of the sharpening (1.0 adds the full difference).
+     * @param threshold The minimum difference (0 to 255) a channel needs to be sharpened; higher values spare noise.
+     */
+    void unsharpMask(double radius, double amount, int threshold);
+
+    /**
+     * @brief Computes the gradient of the pixel intensity with a 3x3 Sobel or Scharr kernel.
+     * The intensity is the mean of the three channels, and the borders are mirrored like in sharpen.
+     * The kernels process eight pixels at a time when SSE2 is available.
+     *
+     * @param op The derivative kernel.
+     * @param with_direction Whether to compute the direction; it is left empty otherwise.
+     * @return The derivatives, magnitude and direction of every pixel.
+     */
+    GradientField gradient(GradientOperator op = GradientOperator::Sobel, bool with_direction = true) const;
+
+    /**
+     * @brief Replaces the image with its gradient magnitude as a grayscale image.
+     *
+     * @param op The derivative kernel.
+     */
+    void applyGradientMagnitude(GradientOperator op = GradientOperator::Sobel);
+
+    /**
+     * @brief Detects edges with the Canny detector.
+     * The gradient magnitude is thinned by non-maximum suppression along the gradient direction, then
+     * pixels above the high threshold seed edges that grow through the pixels above the low threshold.
+     * The hysteresis uses an explicit stack instead of recursion.
+     *
+     * @param low_threshold The magnitude an edge pixel connected to a strong edge needs.
+     * @param high_threshold The magnitude that starts an edge. Both thresholds use the scale of GradientField::magnitude.
+     * @param op The derivative kernel.
+     * @return The edge map in the row order of the image, 255 for edge pixels and 0 elsewhere.
+     */
+    std::vector<uint8_t> canny(double low_threshold, double high_threshold, GradientOperator op = GradientOperator::Sobel) const;
+
+    /**
+     * @brief Replaces the image with its Canny edge map (white edges on black).
+     *
+     * @param low_threshold The magnitude an edge pixel connected to a strong edge needs.
+     * @param high_threshold The magnitude that starts an edge.
+     * @param op The derivative kernel.
+     */
+    void applyCanny(double low_threshold, double high_threshold, GradientOperator op = GradientOperator::Sobel);
+
     /**
      * @brief Converts an RGB color to HSV color space.
      *
@@ -245,6 +456,27 @@ class BMPImage
      */
     void adjustContrast(double contrastFactor);
 
+    /**
+     * @brief Equalizes the histogram of the intensity channel.
+     * The intensity is the mean of the three channels, and every pixel is scaled so that its
+     * intensity follows the normalized cumulative histogram, which keeps hue and saturation.
+     *
+     */
+    void equalizeHistogram();
+
+    /**
+     * @brief Applies contrast-limited adaptive histogram equalization (CLAHE) to the intensity channel.
+     * The image is split into tiles_x by tiles_y tiles. Each tile histogram is clipped at clip_limit
+     * times the mean bin count, the excess is spread over all bins, and the tile mappings are
+     * bilinearly interpolated between tile centers.
+     *
+     * @param tiles_x The number of tiles along the width.
+     * @param tiles_y The number of tiles along the height.
+     * @param clip_limit The clip limit relative to the mean bin count. Values in (0, 1] flatten the mapping
+     * toward the identity; values <= 0 disable clipping, which gives unlimited AHE and the strongest boost.
+     */
+    void applyCLAHE(int tiles_x = 8, int tiles_y = 8, double clip_limit = 2.0);
+
     /**
      * @brief Adjusts the hue of the image.
      *
@@ -10,29 +10,102 @@
  */
 
 #include "bmp.h"
+#include <array>
+#include <cstdlib>
 #include <filesystem>
+#include <iomanip>
 #include <iostream>
+#include <map>
 #include <stdexcept>
+#include <string>
 
 int main(int argc, char* argv[])
 {
     // Check if the user provided the correct number of arguments.
-    if (argc != 3)
+    if (argc < 3)
     {
-        // Update usage instruction to include gamma value
-        std::cerr << "Usage: " << argv[0] << " <input_file> <output_file>" << std::endl;
+        std::cerr << "Usage: " << argv[0]
+                  << " <input_file> <output_file> [--stride <rows>] [--method <gray-world|white-patch|shades-of-gray|gray-edge>] "
+                     "[--estimates]"
+                  << std::endl;
         return 1;
     }
 
-    // Assign the input and output filenames and gamma value.
+    // Assign the input and output filenames.
     std::filesystem::path input_filename(argv[1]);
     std::filesystem::path output_filename(argv[2]);
+    int row_stride = 1;  // estimate the gray-world channel means from every row_stride-th row
+    std::string method = "gray-world";
+    bool print_estimates = false;  // print the estimate of every method, which takes a full pass
+
+    for (int i = 3; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--stride" && i + 1 < argc)
+        {
+            row_stride = std::atoi(argv[++i]);
+        }
+        else if (arg == "--method" && i + 1 < argc)
+        {
+            method = argv[++i];
+        }
+        else if (arg == "--estimates")
+        {
+            print_estimates = true;
+        }
+        else
+        {
+            std::cerr << "Unknown option or missing value: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    const std::map<std::string, std::array<double, 3> IlluminantEstimates::*> methods{
+        { "gray-world", &IlluminantEstimates::gray_world },
+        { "white-patch", &IlluminantEstimates::white_patch },
+        { "shades-of-gray", &IlluminantEstimates::shades_of_gray },
+        { "gray-edge", &IlluminantEstimates::gray_edge }
+    };
+    auto it = methods.find(method);
+    if (it == methods.end())
+    {
+        std::cerr << "Unknown white balance method: " << method << std::endl;
+        return 1;
+    }
+    // Only the sampled gray-world path reads a subset of the rows; the full pass always reads every row
+    if (row_stride != 1 && (method != "gray-world" || print_estimates))
+    {
+        std::cerr << "--stride only applies to gray-world without --estimates" << std::endl;
+        return 1;
+    }
 
     try
     {
         BMPImage image(input_filename);  // Load the input BMP image
-        image.adjustWhiteBalance();      // Adjust the white balance of the image
-        image.write(output_filename);    // Save the modified image to the output file
+
+        // Gray-world only needs the channel means, which can be sampled; the other methods and the report of
+        // every estimate take the full histogram pass
+        if (method == "gray-world" && !print_estimates)
+        {
+            image.adjustWhiteBalance(row_stride);
+        }
+        else
+        {
+            IlluminantEstimates estimates = image.estimateIlluminants();
+            if (print_estimates)
+            {
+                auto print_estimate = [](const std::string& name, const std::array<double, 3>& e) {
+                    std::cout << std::left << std::setw(16) << name << std::fixed << std::setprecision(2) << e[0] << ", " << e[1]
+                              << ", " << e[2] << std::endl;
+                };
+                print_estimate("gray-world:", estimates.gray_world);
+                print_estimate("white-patch:", estimates.white_patch);
+                print_estimate("shades-of-gray:", estimates.shades_of_gray);
+                print_estimate("gray-edge:", estimates.gray_edge);
+            }
+            image.applyWhiteBalance(estimates.*(it->second));
+        }
+        image.write(output_filename);  // Save the modified image to the output file
     }
     catch (const std::runtime_error& e)
     {
@@ -30,6 +30,15 @@ int main(int argc, char* argv[])
     double intensity = 0.0;
     double gamma = 0.0;
     double sharpness = 0.0;
+    double clip = 0.0;
+    int tiles = 8;
+    double clip_limit = 2.0;
+    double radius = 1.0;
+    double amount = 1.0;
+    int threshold = 0;
+    double low = 20.0;
+    double high = 50.0;
+    GradientOperator gradient_operator = GradientOperator::Sobel;
 
     if (argc > 3)
     {
@@ -67,6 +76,48 @@ int main(int argc, char* argv[])
             {
                 sharpness = std::atof(argv[++i]);
             }
+            else if (arg == "--clip" && i + 1 < argc)
+            {
+                clip = std::atof(argv[++i]);
+            }
+            else if (arg == "--tiles" && i + 1 < argc)
+            {
+                tiles = std::atoi(argv[++i]);
+            }
+            else if (arg == "--clip-limit" && i + 1 < argc)
+            {
+                clip_limit = std::atof(argv[++i]);
+            }
+            else if (arg == "--radius" && i + 1 < argc)
+            {
+                radius = std::atof(argv[++i]);
+            }
+            else if (arg == "--amount" && i + 1 < argc)
+            {
+                amount = std::atof(argv[++i]);
+            }
+            else if (arg == "--threshold" && i + 1 < argc)
+            {
+                threshold = std::atoi(argv[++i]);
+            }
+            else if (arg == "--low" && i + 1 < argc)
+            {
+                low = std::atof(argv[++i]);
+            }
+            else if (arg == "--high" && i + 1 < argc)
+            {
+                high = std::atof(argv[++i]);
+            }
+            else if (arg == "--operator" && i + 1 < argc)
+            {
+                std::string name = argv[++i];
+                if (name != "sobel" && name != "scharr")
+                {
+                    std::cerr << "Unknown gradient operator: " << name << std::endl;
+                    return 1;
+                }
+                gradient_operator = (name == "scharr") ? GradientOperator::Scharr : GradientOperator::Sobel;
+            }
             else
             {
                 std::cerr << "Unknown option or missing value: " << arg << std::endl;
@@ -78,7 +129,9 @@ int main(int argc, char* argv[])
     {
         std::cerr << RED << "Usage: " << argv[0]
                   << " <input_file> <output_file> [--sequence <seq>] [--contrast <value>] [--intensity <value>] [--saturation <value>]"
-                     " [--gamma <value>] [--sharpness <value>]"
+                     " [--gamma <value>] [--sharpness <value>] [--clip <percent>]"
+                     " [--tiles <count>] [--clip-limit <value>] [--radius <sigma>] [--amount <value>] [--threshold <level>]"
+                     " [--low <magnitude>] [--high <magnitude>] [--operator <sobel|scharr>]"
                   << std::endl;
         return 1;
     }
@@ -90,7 +143,10 @@ int main(int argc, char* argv[])
         std::map<char, std::function<void()>> operations{
             { 'C', [&]() { image.adjustContrast(contrast); } },     { 'H', [&]() { image.adjustHue(hue); } },
             { 'S', [&]() { image.adjustSaturation(saturation); } }, { 'I', [&]() { image.adjustIntensity(intensity); } },
-            { 'G', [&]() { image.applyGammaCorrection(gamma); } },  { 'A', [&]() { image.sharpen(sharpness); } }
+            { 'G', [&]() { image.applyGammaCorrection(gamma); } },  { 'A', [&]() { image.sharpen(sharpness); } },
+            { 'N', [&]() { image.autoContrast(clip); } },           { 'E', [&]() { image.equalizeHistogram(); } },
+            { 'L', [&]() { image.applyCLAHE(tiles, tiles, clip_limit); } }, { 'U', [&]() { image.unsharpMask(radius, amount, threshold); } },
+            { 'D', [&]() { image.applyGradientMagnitude(gradient_operator); } }, { 'K', [&]() { image.applyCanny(low, high, gradient_operator); } }
         };
 
         // Execute operations in user-defined order
@@ -20,11 +20,109 @@
 #include <stdexcept>
 #include <string>
 
+#include "opencv2/imgproc.hpp"
+
 BMPImage::BMPImage(const std::filesystem::path& filename)
 {
     read(filename);
 }
 
+BMPImage::BMPImage(const cv::Mat& image)
+{
+    if (image.empty() || image.depth() != CV_8U)
+    {
+        throw std::invalid_argument("Only 8-bit images can be converted to BMP images");
+    }
+    switch (image.channels())
+    {
+        case 4:
+            pixels = image.isContinuous() ? image : image.clone();
+            break;
+        case 3:
+            cv::cvtColor(image, pixels, cv::COLOR_BGR2BGRA);
+            break;
+        case 1:
+            cv::cvtColor(image, pixels, cv::COLOR_GRAY2BGRA);
+            break;
+        default:
+            throw std::invalid_argument("Unsupported channel count: " + std::to_string(image.channels()));
+    }
+    int row_size = (image.cols * 3 + 3) / 4 * 4;
+
+    info_header = BMPInfoHeader{};
+    info_header.size = sizeof(BMPInfoHeader);
+    info_header.width = image.cols;
+    info_header.height = image.rows;
+    info_header.planes = 1;
+    info_header.bit_count = 24;
+    info_header.image_size = static_cast<uint32_t>(row_size) * image.rows;
+
+    header = BMPFileHeader{};
+    header.type = 0x4D42;
+    header.offset = sizeof(BMPFileHeader) + sizeof(BMPInfoHeader);
+    header.size = header.offset + info_header.image_size;
+}
+
+BMPImage::BMPImage(const BMPImage& other)
+  : header(other.header), info_header(other.info_header), pixels(other.pixels.clone())
+{
+}
+
+BMPImage& BMPImage::operator=(const BMPImage& other)
+{
+    if (this != &other)
+    {
+        header = other.header;
+        info_header = other.info_header;
+        pixels = other.pixels.clone();
+    }
+    return *this;
+}
+
+cv::Mat BMPImage::asMat()
+{
+    return pixels;
+}
+
+cv::Mat BMPImage::asMat() const
+{
+    return pixels.clone();
+}
+
+BMPImage::PixelRange<Pixel> BMPImage::allPixels()
+{
+    Pixel* first = pixels.ptr<Pixel>(0);
+    return PixelRange<Pixel>{ first, first + pixels.total() };
+}
+
+BMPImage::PixelRange<const Pixel> BMPImage::allPixels() const
+{
+    const Pixel* first = pixels.ptr<Pixel>(0);
+    return PixelRange<const Pixel>{ first, first + pixels.total() };
+}
+
+std::vector<std::vector<Pixel>> BMPImage::toRows() const
+{
+    std::vector<std::vector<Pixel>> rows(pixels.rows);
+    for (int y = 0; y < pixels.rows; ++y)
+    {
+        const Pixel* row = pixels.ptr<Pixel>(y);
+        rows[y].assign(row, row + pixels.cols);
+    }
+    return rows;
+}
+
+void BMPImage::fromRows(const std::vector<std::vector<Pixel>>& rows)
+{
+    int height = static_cast<int>(rows.size());
+    int width = height > 0 ? static_cast<int>(rows[0].size()) : 0;
+    pixels.create(height, width, CV_8UC4);
+    for (int y = 0; y < height; ++y)
+    {
+        std::copy(rows[y].begin(), rows[y].end(), pixels.ptr<Pixel>(y));
+    }
+}
+
 void BMPImage::read(const std::filesystem::path& filename)
 {
     std::ifstream file(filename, std::ios::binary);
@@ -42,8 +140,8 @@ void BMPImage::read(const std::filesystem::path& filename)
         throw std::ios_base::failure("Unsupported bit count: " + std::to_string(info_header.bit_count));
     }
 
-    // Resize the pixel data grid
-    pixels.resize(info_header.height, std::vector<Pixel>(info_header.width));
+    // Allocate the pixel data; a shared buffer is left to its other owners
+    pixels = cv::Mat(info_header.height, info_header.width, CV_8UC4);
 
     // Seek to the pixel data beginning
     file.seekg(header.offset, file.beg);
@@ -51,10 +149,13 @@ void BMPImage::read(const std::filesystem::path& filename)
     // Read the pixel data
     int padding = (4 - (info_header.width * (info_header.bit_count / 8)) % 4) % 4;
 
-    for (auto& row : pixels)
+    // The file stores the rows bottom-up
+    for (int y = info_header.height - 1; y >= 0; --y)
     {
-        for (auto& pixel : row)
+        Pixel* row = pixels.ptr<Pixel>(y);
+        for (int x = 0; x < info_header.width; ++x)
         {
+            Pixel& pixel = row[x];
             file.read(reinterpret_cast<char*>(&pixel), info_header.bit_count / 8);
 
             if (info_header.bit_count == 24)
@@ -83,11 +184,12 @@ void BMPImage::write(const std::filesystem::path& filename)
     std::vector<char> pad(padding, 0);
 
     // Write the pixel data
-    for (const auto& row : pixels)
+    for (int y = info_header.height - 1; y >= 0; --y)
     {
-        for (const auto& pixel : row)
+        const Pixel* row = pixels.ptr<Pixel>(y);
+        for (int x = 0; x < info_header.width; ++x)
         {
-            file.write(reinterpret_cast<const char*>(&pixel), info_header.bit_count / 8);
+            file.write(reinterpret_cast<const char*>(&row[x]), info_header.bit_count / 8);
         }
         if (padding > 0)
         {
@@ -113,7 +215,7 @@ Pixel BMPImage::getPixel(int x, int y) const
         throw std::out_of_range("Pixel coordinates out of range");
     }
 
-    return pixels[y][x];
+    return pixels.ptr<Pixel>(info_header.height - 1 - y)[x];
 }
 
 void BMPImage::setPixel(int x, int y, const Pixel& pixel)
@@ -123,7 +225,7 @@ void BMPImage::setPixel(int x, int y, const Pixel& pixel)
         throw std::out_of_range("Pixel coordinates out of range");
     }
 
-    pixels[y][x] = pixel;
+    pixels.ptr<Pixel>(info_header.height - 1 - y)[x] = pixel;
 }
 
 void BMPImage::adjustWhiteBalance()
@@ -131,14 +233,11 @@ void BMPImage::adjustWhiteBalance()
     // Calculate average values
     long long total_r = 0, total_g = 0, total_b = 0;
 
-    for (const auto& row : pixels)
+    for (const auto& [r, g, b, a] : allPixels())
     {
-        for (const auto& [r, g, b, a] : row)
-        {
-            total_r += r;
-            total_g += g;
-            total_b += b;
-        }
+        total_r += r;
+        total_g += g;
+        total_b += b;
     }
 
     int pixel_count = info_header.width * info_header.height;
@@ -154,14 +253,11 @@ void BMPImage::adjustWhiteBalance()
     double b_factor = avg_grey / avg_b;
 
     // Adjust pixels
-    for (auto& row : pixels)
+    for (auto& [r, g, b, a] : allPixels())
     {
-        for (auto& [r, g, b, a] : row)
-        {
-            r = std::clamp(static_cast<int>(r * r_factor), 0, 255);
-            g = std::clamp(static_cast<int>(g * g_factor), 0, 255);
-            b = std::clamp(static_cast<int>(b * b_factor), 0, 255);
-        }
+        r = std::clamp(static_cast<int>(r * r_factor), 0, 255);
+        g = std::clamp(static_cast<int>(g * g_factor), 0, 255);
+        b = std::clamp(static_cast<int>(b * b_factor), 0, 255);
     }
 }
 
@@ -192,7 +288,7 @@ std::vector<std::vector<Pixel>> BMPImage::mirrorPadding(const std::vector<std::v
 
 void BMPImage::mirrorPadding(int edge)
 {
-    pixels = mirrorPadding(pixels, edge);
+    fromRows(mirrorPadding(toRows(), edge));
     info_header.width += 2 * edge;
     info_header.height += 2 * edge;
 }
@@ -208,7 +304,7 @@ void BMPImage::sharpen(double sharpness)
     // clang-format on
     int edge = kernel.size() / 2;
 
-    std::vector<std::vector<Pixel>> padded_pixels = mirrorPadding(pixels, edge);
+    std::vector<std::vector<Pixel>> padded_pixels = mirrorPadding(toRows(), edge);
 
     // Iterate over each pixel (excluding the border pixels)
     for (int y = 0; y < info_header.height; ++y)
@@ -232,9 +328,10 @@ void BMPImage::sharpen(double sharpness)
             }
 
             // Combine the sharpened values with the original pixel values
-            pixels[y][x].r = static_cast<uint8_t>(std::clamp(static_cast<int>(pixels[y][x].r + sharpness * red), 0, 255));
-            pixels[y][x].g = static_cast<uint8_t>(std::clamp(static_cast<int>(pixels[y][x].g + sharpness * green), 0, 255));
-            pixels[y][x].b = static_cast<uint8_t>(std::clamp(static_cast<int>(pixels[y][x].b + sharpness * blue), 0, 255));
+            Pixel& pixel = pixels.ptr<Pixel>(y)[x];
+            pixel.r = static_cast<uint8_t>(std::clamp(static_cast<int>(pixel.r + sharpness * red), 0, 255));
+            pixel.g = static_cast<uint8_t>(std::clamp(static_cast<int>(pixel.g + sharpness * green), 0, 255));
+            pixel.b = static_cast<uint8_t>(std::clamp(static_cast<int>(pixel.b + sharpness * blue), 0, 255));
         }
     }
 }
@@ -371,69 +468,60 @@ void BMPImage::HSItoRGB(double h, double s, double i, double& r, double& g, doub
 
 void BMPImage::adjustSaturation(double saturation_factor)
 {
-    for (auto& row : pixels)
+    for (auto& pixel : allPixels())
     {
-        for (auto& pixel : row)
-        {
-            double h, s, i;
-            RGBtoHSI(pixel.r / 255.0, pixel.g / 255.0, pixel.b / 255.0, h, s, i);
+        double h, s, i;
+        RGBtoHSI(pixel.r / 255.0, pixel.g / 255.0, pixel.b / 255.0, h, s, i);
 
-            s *= saturation_factor;
-            s = std::clamp(s, 0.0, 1.0);
-            double r, g, b;
-            HSItoRGB(h, s, i, r, g, b);
+        s *= saturation_factor;
+        s = std::clamp(s, 0.0, 1.0);
+        double r, g, b;
+        HSItoRGB(h, s, i, r, g, b);
 
-            pixel.r = static_cast<uint8_t>(std::round(r * 255));
-            pixel.g = static_cast<uint8_t>(std::round(g * 255));
-            pixel.b = static_cast<uint8_t>(std::round(b * 255));
-        }
+        pixel.r = static_cast<uint8_t>(std::round(r * 255));
+        pixel.g = static_cast<uint8_t>(std::round(g * 255));
+        pixel.b = static_cast<uint8_t>(std::round(b * 255));
     }
 }
 
 void BMPImage::adjustHue(double hue_adjustment)
 {
-    for (auto& row : pixels)
+    for (auto& pixel : allPixels())
     {
-        for (auto& pixel : row)
-        {
-            double h, s, i;
-            RGBtoHSI(pixel.r / 255.0, pixel.g / 255.0, pixel.b / 255.0, h, s, i);
+        double h, s, i;
+        RGBtoHSI(pixel.r / 255.0, pixel.g / 255.0, pixel.b / 255.0, h, s, i);
 
-            h += hue_adjustment;
-            if (h > 360)
-                h -= 360;
-            else if (h < 0)
-                h += 360;
+        h += hue_adjustment;
+        if (h > 360)
+            h -= 360;
+        else if (h < 0)
+            h += 360;
 
-            double r, g, b;
-            HSItoRGB(h, s, i, r, g, b);
+        double r, g, b;
+        HSItoRGB(h, s, i, r, g, b);
 
-            pixel.r = static_cast<uint8_t>(std::round(r * 255));
-            pixel.g = static_cast<uint8_t>(std::round(g * 255));
-            pixel.b = static_cast<uint8_t>(std::round(b * 255));
-        }
+        pixel.r = static_cast<uint8_t>(std::round(r * 255));
+        pixel.g = static_cast<uint8_t>(std::round(g * 255));
+        pixel.b = static_cast<uint8_t>(std::round(b * 255));
     }
 }
 
 void BMPImage::adjustIntensity(double intensity_factor)
 {
-    for (auto& row : pixels)
+    for (auto& pixel : allPixels())
     {
-        for (auto& pixel : row)
-        {
-            double h, s, i;
-            RGBtoHSI(pixel.r / 255.0, pixel.g / 255.0, pixel.b / 255.0, h, s, i);
+        double h, s, i;
+        RGBtoHSI(pixel.r / 255.0, pixel.g / 255.0, pixel.b / 255.0, h, s, i);
 
-            i *= intensity_factor;
-            i = std::clamp(i, 0.0, 1.0);
+        i *= intensity_factor;
+        i = std::clamp(i, 0.0, 1.0);
 
-            double r, g, b;
-            HSItoRGB(h, s, i, r, g, b);
+        double r, g, b;
+        HSItoRGB(h, s, i, r, g, b);
 
-            pixel.r = static_cast<uint8_t>(std::round(r * 255));
-            pixel.g = static_cast<uint8_t>(std::round(g * 255));
-            pixel.b = static_cast<uint8_t>(std::round(b * 255));
-        }
+        pixel.r = static_cast<uint8_t>(std::round(r * 255));
+        pixel.g = static_cast<uint8_t>(std::round(g * 255));
+        pixel.b = static_cast<uint8_t>(std::round(b * 255));
     }
 }
 
@@ -444,29 +532,21 @@ void BMPImage::applyGammaCorrection(float gamma)
         throw std::runtime_error("Gamma value must be greater than 0");
     }
 
-    // Iterate over all rows of pixels
-    for (auto& row : pixels)
+    for (auto& pixel : allPixels())
     {
-        // Iterate over each pixel in the row
-        for (auto& pixel : row)
-        {
-            // Apply gamma correction formula to each channel
-            pixel.r = std::pow(pixel.r / 255.0f, gamma) * 255;
-            pixel.g = std::pow(pixel.g / 255.0f, gamma) * 255;
-            pixel.b = std::pow(pixel.b / 255.0f, gamma) * 255;
-        }
+        // Apply gamma correction formula to each channel
+        pixel.r = std::pow(pixel.r / 255.0f, gamma) * 255;
+        pixel.g = std::pow(pixel.g / 255.0f, gamma) * 255;
+        pixel.b = std::pow(pixel.b / 255.0f, gamma) * 255;
     }
 }
 
 void BMPImage::adjustContrast(double contrastFactor)
 {
-    for (auto& row : pixels)
+    for (auto& pixel : allPixels())
     {
-        for (auto& pixel : row)
-        {
-            pixel.r = std::clamp(128 + static_cast<int>(contrastFactor * (pixel.r - 128)), 0, 255);
-            pixel.g = std::clamp(128 + static_cast<int>(contrastFactor * (pixel.g - 128)), 0, 255);
-            pixel.b = std::clamp(128 + static_cast<int>(contrastFactor * (pixel.b - 128)), 0, 255);
-        }
+        pixel.r = std::clamp(128 + static_cast<int>(contrastFactor * (pixel.r - 128)), 0, 255);
+        pixel.g = std::clamp(128 + static_cast<int>(contrastFactor * (pixel.g - 128)), 0, 255);
+        pixel.b = std::clamp(128 + static_cast<int>(contrastFactor * (pixel.b - 128)), 0, 255);
     }
 }
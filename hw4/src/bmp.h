@@ -18,6 +18,8 @@
 #include <stdint.h>
 #include <vector>
 
+#include "opencv2/core/mat.hpp"
+
 #define RESET "\033[0m"
 #define BLACK "\033[30m"
 #define RED "\033[31m"
@@ -104,13 +106,42 @@ struct Pixel
  *
  * This class provides the capability to read and write BMP image files, as well as perform
  * various operations on the image data such as flipping, quantization, and scaling.
+ * The pixels are kept in one continuous CV_8UC4 matrix with the rows top-down, so OpenCV can work on them in place;
+ * the y coordinate of getPixel and setPixel still counts rows bottom-up, in the order of the file.
  */
 class BMPImage
 {
   private:
     BMPFileHeader header;
     BMPInfoHeader info_header;
-    std::vector<std::vector<Pixel>> pixels;
+    cv::Mat pixels;
+
+    template <typename T>
+    struct PixelRange
+    {
+        T* first;
+        T* last;
+        T* begin() const
+        {
+            return first;
+        }
+        T* end() const
+        {
+            return last;
+        }
+    };
+
+    /**
+     * @brief Returns every pixel as one range, for operations that treat all pixels alike.
+     */
+    PixelRange<Pixel> allPixels();
+    PixelRange<const Pixel> allPixels() const;
+
+    /**
+     * @brief Copies the pixels to and from the rows of mirrorPadding, in storage order.
+     */
+    std::vector<std::vector<Pixel>> toRows() const;
+    void fromRows(const std::vector<std::vector<Pixel>>& rows);
 
   public:
     /**
@@ -120,6 +151,35 @@ class BMPImage
      */
     BMPImage(const std::filesystem::path& filename);
 
+    /**
+     * @brief Construct a new 24-bit BMPImage object from an OpenCV image.
+     * A continuous CV_8UC4 (BGRA) matrix is wrapped without a copy, so the image and the matrix share their pixels;
+     * CV_8UC3 (BGR) and CV_8UC1 images are converted to BGRA.
+     *
+     * @param image The image, with the rows top-down as OpenCV stores them.
+     */
+    explicit BMPImage(const cv::Mat& image);
+
+    /**
+     * @brief Copies an image; the copy does not share the pixels.
+     */
+    BMPImage(const BMPImage& other);
+    BMPImage& operator=(const BMPImage& other);
+    BMPImage(BMPImage&& other) = default;
+    BMPImage& operator=(BMPImage&& other) = default;
+
+    /**
+     * @brief Returns a CV_8UC4 (BGRA) matrix header over the pixels, without a copy.
+     * The rows are top-down, and writing through the matrix changes the image.
+     */
+    cv::Mat asMat();
+
+    /**
+     * @brief Returns a CV_8UC4 (BGRA) copy of the pixels, since a matrix header cannot be read-only.
+     * The rows are top-down; callers that only read a non-const image get the view of the overload above.
+     */
+    cv::Mat asMat() const;
+
     /**
      * @brief Reads an image from a BMP file.
      *
@@ -11,21 +11,130 @@
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "bmp.h"
+#include "opencv2/core/mat.hpp"
+#include "opencv2/imgcodecs.hpp"
+#include "parallel.h"
 #include "psnr.h"
 #include "restore_cv.h"
+#include "search.h"
+#include "sweep.h"
 
 int main(int argc, char* argv[])
 {
-    if (argc != 2)
+    if (argc < 2)
     {
-        std::cerr << "Usage: " << argv[0] << " <input_file>" << std::endl;
+        std::cerr << "Usage: " << argv[0]
+                  << " <0|1> [--fused] [--method grid|coarse-to-fine|brent|nelder-mead] [--len range] [--theta range] "
+                     "[--snr1 range] [--r range] [--snr2 range] [--threads n] [--tile n] [--pad] [--rl iterations] "
+                     "[--rl-tol t] [--csv file] [--json file]"
+                  << std::endl;
+        std::cerr << "A range is a value or first:last:step; with --fused, snr1 is the snr of the single pass" << std::endl;
         return 1;
     }
     // if_search_param is true if argv[1] is 1, false otherwise.
     bool if_search_param = (std::stoi(argv[1]) == 1);
 
+    SweepRanges ranges{ ParamRange{ 30, 30, 1 }, ParamRange{ 45, 45, 1 }, ParamRange{ 21.0, 21.2, 0.01 },
+                        ParamRange{ 1, 1, 1 }, ParamRange{ 26.65, 26.85, 0.01 } };
+    bool fused = false;
+    bool pad_band = false;
+    bool snr1_given = false;
+    SearchMethod method = SearchMethod::Grid;
+    unsigned thread_count = 0;
+    int tile_size = 0;
+    int rl_iterations = 0;
+    double rl_tolerance = 0.0;
+    std::filesystem::path csv_filename;
+    std::filesystem::path json_filename;
+    try
+    {
+        for (int i = 2; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--fused")
+            {
+                fused = true;
+            }
+            else if (arg == "--method" && i + 1 < argc)
+            {
+                method = parseSearchMethod(argv[++i]);
+            }
+            else if (arg == "--len" && i + 1 < argc)
+            {
+                ranges.len = ParamRange::parse(argv[++i]);
+            }
+            else if (arg == "--theta" && i + 1 < argc)
+            {
+                ranges.theta = ParamRange::parse(argv[++i]);
+            }
+            else if (arg == "--snr1" && i + 1 < argc)
+            {
+                ranges.snr1 = ParamRange::parse(argv[++i]);
+                snr1_given = true;
+            }
+            else if (arg == "--r" && i + 1 < argc)
+            {
+                ranges.r = ParamRange::parse(argv[++i]);
+            }
+            else if (arg == "--snr2" && i + 1 < argc)
+            {
+                ranges.snr2 = ParamRange::parse(argv[++i]);
+            }
+            else if (arg == "--threads" && i + 1 < argc)
+            {
+                thread_count = static_cast<unsigned>(std::stoul(argv[++i]));
+            }
+            else if (arg == "--tile" && i + 1 < argc)
+            {
+                tile_size = std::stoi(argv[++i]);
+            }
+            else if (arg == "--pad")
+            {
+                pad_band = true;
+            }
+            else if (arg == "--rl" && i + 1 < argc)
+            {
+                rl_iterations = std::stoi(argv[++i]);
+            }
+            else if (arg == "--rl-tol" && i + 1 < argc)
+            {
+                rl_tolerance = std::stod(argv[++i]);
+            }
+            else if (arg == "--csv" && i + 1 < argc)
+            {
+                csv_filename = argv[++i];
+            }
+            else if (arg == "--json" && i + 1 < argc)
+            {
+                json_filename = argv[++i];
+            }
+            else
+            {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    if (fused)
+    {
+        // The combined filter needs a higher snr than either pass; snr2 is unused
+        if (!snr1_given)
+        {
+            ranges.snr1 = ParamRange{ 25.0, 32.0, 0.25 };
+        }
+        ranges.snr2 = ParamRange{ ranges.snr2.first, ranges.snr2.first, 1 };
+    }
+
     if (if_search_param)
     {
         std::cout << "searching parameters..." << std::endl;
@@ -38,7 +147,7 @@ int main(int argc, char* argv[])
     // Assign the input and output filenames and gamma value.
     std::filesystem::path input1_filename("input/input1.bmp");
     std::filesystem::path input1_ori_filename("input/input1_ori.bmp");
-    std::filesystem::path input2_filename("input/input2.bmp");
+    std::filesystem::path input2_filename("input/input2.jpg");
 
     std::filesystem::path output1_demotion_filename("output/output1_demotion.bmp");
     std::filesystem::path output1_filename("output/output1.bmp");
@@ -54,68 +163,117 @@ int main(int argc, char* argv[])
     {
         BMPImage input1_image(input1_filename);
         BMPImage input1_ori_image(input1_ori_filename);
-        BMPImage input2_image(input2_filename);
+        // input2 only comes as a JPEG, which BMPImage cannot read
+        cv::Mat input2 = cv::imread(input2_filename.string(), cv::IMREAD_COLOR);
+        if (input2.empty())
+        {
+            throw std::runtime_error("Cannot read " + input2_filename.string());
+        }
+        BMPImage input2_image(input2);
 
         PSNR psnr(input1_ori_image, input1_image);
         std::cout << input1_filename << ", " << input1_ori_filename << std::endl;
         psnr.calPrint();
 
-        int len = 30;
-        double theta = 45;
-        // double snr1 = 23;
-        // int r = 1;
-        // double snr2 = 5.0;
-
-        double max_snr1 = 21.09;
+        int max_len = 30;
+        double max_theta = 45;
+        double max_snr1 = fused ? 28.25 : 21.09;
         int max_r = 1;
         double max_snr2 = 26.71;
         double max_psnr = 0.0;
 
         if (if_search_param)
         {
-            for (double snr1 = 21.0; snr1 <= 21.2; snr1 += 0.01)
+            // Every candidate is restored and scored in memory, straight from the pixels of the loaded images;
+            // the grid and coarse-to-fine searches use all cores
+            ParameterSweep sweep(input1_image.asMat(), input1_ori_image.asMat(), ranges, fused, pad_band);
+            SweepLog log(csv_filename, json_filename);
+            int evaluations = 0;
+            SweepResult best = searchParameters(sweep, ranges, method, thread_count, [&](const SweepResult& result) {
+                const RestoreParams& p = result.params;
+                std::cout << std::fixed << std::setprecision(2);
+                std::cout << "len: " << std::setw(3) << p.len << ", theta: " << std::setw(6) << p.theta << ", snr1: " << std::setw(5)
+                          << p.snr1 << ", r: " << std::setw(2) << p.r << ", snr2: " << std::setw(5) << p.snr2
+                          << ", psnr: " << std::setw(10) << std::setprecision(6) << result.psnr << std::endl;
+                log.write(result);
+                ++evaluations;
+            });
+            std::cout << "evaluations: " << evaluations << std::endl;
+
+            max_len = best.params.len;
+            max_theta = best.params.theta;
+            max_snr1 = best.params.snr1;
+            max_r = best.params.r;
+            max_snr2 = best.params.snr2;
+            max_psnr = best.psnr;
+        }
+
+        std::cout << "max_len: " << max_len << ", max_theta: " << max_theta << ", max_snr1: " << max_snr1 << ", max_r: " << max_r << ", max_snr2: " << max_snr2 << ", max_psnr: " << max_psnr << std::endl;
+
+        // The images are restored concurrently, and the threads left over go to the channels or tiles of each image.
+        // Each stage works on the pixels of the previous one in memory; the files are only written for inspection.
+        struct RestoreJob
+        {
+            BMPImage& input;
+            std::filesystem::path demotion;
+            std::filesystem::path output;
+            std::filesystem::path psf_motion;
+            std::filesystem::path psf_oof;
+        };
+        const std::vector<RestoreJob> jobs{
+            { input1_image, output1_demotion_filename, output1_filename, psf_motion_1_filename, psf_oof_1_filename },
+            { input2_image, output2_demotionfilename, output2_filename, psf_motion_2_filename, psf_oof_2_filename }
+        };
+        std::vector<cv::Mat> restored(jobs.size());
+        unsigned total_threads = thread_count > 0 ? thread_count : std::max(1u, std::thread::hardware_concurrency());
+        unsigned image_threads = resolveThreadCount(total_threads, jobs.size());
+        unsigned inner_threads = std::max(1u, total_threads / image_threads);
+        parallelFor(jobs.size(), image_threads, [&](size_t i) {
+            const RestoreJob& job = jobs[i];
+            cv::Mat demotion;
+            if (rl_iterations > 0)
             {
-                for (int r = 1; r <= 1; r += 1)
+                // Richardson-Lucy with the parameters found for the Wiener filter; the snr values do not apply
+                if (fused)
                 {
-                    for (double snr2 = 26.65; snr2 <= 26.85; snr2 += 0.01)
-                    {
-                        process_motion_blur(input1_filename, output1_demotion_filename, psf_motion_1_filename, len, theta, snr1);
-                        process_oof_blur(output1_demotion_filename, output1_filename, psf_oof_1_filename, r, snr2);
-                        PSNR psnr(input1_ori_filename, output1_filename);
-                        double psnr_val = psnr.calculatePSNR();
-                        std::cout << std::fixed << std::setprecision(2);
-                        std::cout << "snr1: " << std::setw(5) << snr1 << ", r: " << std::setw(2) << r << ", snr2: " << std::setw(5) << snr2
-                                  << ", psnr: " << std::setw(10) << std::setprecision(6) << psnr_val << std::endl;
-
-                        if (psnr_val > max_psnr)
-                        {
-                            max_snr1 = snr1;
-                            max_r = r;
-                            max_snr2 = snr2;
-                            max_psnr = psnr_val;
-                        }
-                    }
+                    process_rl_blur(job.input.asMat(), restored[i], "", PSFParams::combined(max_len, max_theta, max_r),
+                                    rl_iterations, rl_tolerance, inner_threads, pad_band);
+                }
+                else
+                {
+                    process_rl_blur(job.input.asMat(), demotion, job.psf_motion, PSFParams::motion(max_len, max_theta),
+                                    rl_iterations, rl_tolerance, inner_threads, pad_band);
+                    process_rl_blur(demotion, restored[i], job.psf_oof, PSFParams::circle(max_r), rl_iterations,
+                                    rl_tolerance, inner_threads, pad_band);
                 }
             }
-        }
-
-        std::cout << "max_snr1: " << max_snr1 << ", max_r: " << max_r << ", max_snr2: " << max_snr2 << ", max_psnr: " << max_psnr << std::endl;
-
-        process_motion_blur(input1_filename, output1_demotion_filename, psf_motion_1_filename, len, theta, max_snr1);
-        process_oof_blur(output1_demotion_filename, output1_filename, psf_oof_1_filename, max_r, max_snr2);
-
-        process_motion_blur(input2_filename, output2_demotionfilename, psf_motion_2_filename, len, theta, max_snr1);
-        process_oof_blur(output2_demotionfilename, output2_filename, psf_oof_2_filename, max_r, max_snr2);
+            else if (fused)
+            {
+                process_fused_blur(job.input.asMat(), restored[i], max_len, max_theta, max_r, max_snr1, inner_threads,
+                                   tile_size, pad_band);
+            }
+            else
+            {
+                process_motion_blur(job.input.asMat(), demotion, job.psf_motion, max_len, max_theta, max_snr1, inner_threads,
+                                    tile_size, pad_band);
+                process_oof_blur(demotion, restored[i], job.psf_oof, max_r, max_snr2, inner_threads, tile_size, pad_band);
+            }
+            if (!demotion.empty())
+            {
+                BMPImage(demotion).write(job.demotion);
+            }
+            BMPImage(restored[i]).write(job.output);
+        });
 
         // PSNR psnr_demotion(output1_demotion_filename, input1_ori_filename);
         // std::cout << "output1_demotion.bmp, " << input1_ori_filename << std::endl;
         // psnr_demotion.calPrint();
 
-        PSNR psnr_result(output1_filename, input1_ori_filename);
+        PSNR psnr_result(input1_ori_image, BMPImage(restored[0]));
         std::cout << "output1.bmp, " << input1_ori_filename << std::endl;
         psnr_result.calPrint();
     }
-    catch (const std::runtime_error& e)
+    catch (const std::exception& e)
     {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
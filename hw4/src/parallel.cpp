@@ -0,0 +1,227 @@
+/**
+ * @file parallel.cpp
+ * @brief The bounded worker pool of parallel.h.
+ * @version 0.1
+ * @date 2023-12-18
+ *
+ */
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+unsigned resolveThreadCount(unsigned thread_count, size_t task_count)
+{
+    if (thread_count == 0)
+    {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return unsigned(std::max<size_t>(1, std::min<size_t>(thread_count, task_count)));
+}
+
+namespace
+{
+/**
+ * @brief One parallelFor call: the pool threads that pick up one of its slots join the calling thread on its tasks.
+ */
+struct Batch
+{
+    Batch(size_t count, const std::function<void(size_t, unsigned)>& task) : count(count), task(task) {}
+
+    /**
+     * @brief Runs tasks until none is left, as the given worker.
+     */
+    void work(unsigned worker)
+    {
+        for (size_t i = next++; i < count; i = next++)
+        {
+            try
+            {
+                task(i, worker);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+                next = count;
+            }
+        }
+    }
+
+    /**
+     * @brief Runs the tasks as a pool thread, unless the caller has already finished them.
+     */
+    void help()
+    {
+        unsigned worker;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (closed)
+            {
+                return;
+            }
+            worker = joined++;
+            running++;
+        }
+        work(worker);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--running == 0)
+        {
+            done.notify_one();
+        }
+    }
+
+    /**
+     * @brief Turns away the slots not picked up yet and waits for the pool threads already working.
+     */
+    void close()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        closed = true;
+        done.wait(lock, [this] { return running == 0; });
+    }
+
+    const size_t count;
+    const std::function<void(size_t, unsigned)>& task;
+    std::atomic<size_t> next{ 0 };
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+    unsigned joined = 1;
+    unsigned running = 0;
+    bool closed = false;
+};
+
+/**
+ * @brief The process-wide threads: each waits for a batch slot and helps that batch until its tasks run out.
+ */
+class ThreadPool
+{
+public:
+    static ThreadPool& instance()
+    {
+        static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+        return pool;
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    /**
+     * @brief The number of pool threads.
+     */
+    unsigned size() const { return unsigned(threads.size()); }
+
+    /**
+     * @brief Offers the batch to slot_count pool threads.
+     */
+    void post(const std::shared_ptr<Batch>& batch, unsigned slot_count)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (unsigned s = 0; s < slot_count; ++s)
+            {
+                slots.push_back(batch);
+            }
+        }
+        if (slot_count == 1)
+        {
+            wake.notify_one();
+        }
+        else
+        {
+            wake.notify_all();
+        }
+    }
+
+private:
+    explicit ThreadPool(unsigned thread_count)
+    {
+        for (unsigned t = 0; t < thread_count; ++t)
+        {
+            threads.emplace_back([this] { loop(); });
+        }
+    }
+
+    void loop()
+    {
+        for (;;)
+        {
+            std::shared_ptr<Batch> batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !slots.empty(); });
+                if (slots.empty())
+                {
+                    return;
+                }
+                batch = std::move(slots.front());
+                slots.pop_front();
+            }
+            batch->help();
+        }
+    }
+
+    std::vector<std::thread> threads;
+    std::deque<std::shared_ptr<Batch>> slots;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
+}  // namespace
+
+void parallelFor(size_t count, unsigned thread_count, const std::function<void(size_t, unsigned)>& task)
+{
+    thread_count = resolveThreadCount(thread_count, count);
+    if (thread_count > 1)
+    {
+        thread_count = std::min(thread_count, ThreadPool::instance().size() + 1);
+    }
+    if (thread_count == 1)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            task(i, 0);
+        }
+        return;
+    }
+
+    // The pool threads hold the batch through their slots, which may outlive this call when they are picked up late
+    auto batch = std::make_shared<Batch>(count, task);
+    ThreadPool::instance().post(batch, thread_count - 1);
+    batch->work(0);
+    batch->close();
+    if (batch->error)
+    {
+        std::rethrow_exception(batch->error);
+    }
+}
+
+void parallelFor(size_t count, unsigned thread_count, const std::function<void(size_t)>& task)
+{
+    parallelFor(count, thread_count, [&task](size_t i, unsigned) { task(i); });
+}
@@ -0,0 +1,42 @@
+/**
+ * @file parallel.h
+ * @brief A persistent, bounded worker pool for independent tasks: the channels of an image, the tiles of a
+ * restoration, the images of a batch, or the candidates of a sweep.
+ * @version 0.1
+ * @date 2023-12-18
+ *
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stddef.h>
+
+#include <functional>
+
+/**
+ * @brief Resolves a requested thread count: 0 means one thread per core, and there are never more threads than tasks.
+ */
+unsigned resolveThreadCount(unsigned thread_count, size_t task_count);
+
+/**
+ * @brief Runs task(0, worker) ... task(count - 1, worker) on up to thread_count threads, the calling thread being
+ * one of them. The other threads come from one process-wide pool that is started on first use and kept until exit,
+ * with one thread fewer than there are cores, so repeated calls do not spawn threads and nested calls never
+ * oversubscribe: a call made from inside a task borrows the idle pool threads and otherwise runs on its caller.
+ * The tasks are handed out one at a time, so uneven tasks still balance. The first exception stops the tasks that
+ * have not started and is rethrown once every thread has finished its current task.
+ *
+ * @param count The number of tasks.
+ * @param thread_count The maximum number of threads, or 0 for one per core.
+ * @param task The task, called with its index and with the index in [0, thread_count) of the thread running it, which
+ * no other thread of the same call uses at the same time, so it can select per-thread scratch.
+ */
+void parallelFor(size_t count, unsigned thread_count, const std::function<void(size_t, unsigned)>& task);
+
+/**
+ * @brief Runs task(0) ... task(count - 1) like the overload above, for tasks that need no per-thread scratch.
+ */
+void parallelFor(size_t count, unsigned thread_count, const std::function<void(size_t)>& task);
+
+#endif  // PARALLEL_H
@@ -3,6 +3,9 @@
 #include <math.h>
 
 #include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 #include "opencv2/core.hpp"
@@ -17,42 +20,363 @@
 #include "opencv2/core/traits.hpp"
 #include "opencv2/imgcodecs.hpp"
 #include "opencv2/imgproc.hpp"
+#include "parallel.h"
 
-void calcMotionPSF(cv::Mat& outputImg, cv::Size filterSize, const std::filesystem::path& output_path, int len, double theta)
+namespace
+{
+cv::Mat drawMotionPSF(cv::Size filterSize, int len, double theta)
 {
     cv::Mat h(filterSize, CV_32F, cv::Scalar(0));
     cv::Point point(filterSize.width / 2, filterSize.height / 2);
     cv::ellipse(h, point, cv::Size(0, cvRound(float(len) / 2.0)), 90.0 - theta, 0, 360, cv::Scalar(255), cv::FILLED);
-    cv::Scalar summa = cv::sum(h);
-    outputImg = h / summa[0];
-    h.convertTo(h, CV_8U);
-    cv::imwrite(output_path, h);
+    return h;
 }
 
-void calcCirclePSF(cv::Mat& outputImg, cv::Size filterSize, const std::filesystem::path& output_path, int r)
+cv::Mat drawCirclePSF(cv::Size filterSize, int r)
 {
     cv::Mat h(filterSize, CV_32F, cv::Scalar(0));
     cv::Point point(filterSize.width / 2, filterSize.height / 2);
     cv::circle(h, point, r, 255, -1, 8);
-    cv::Scalar summa = sum(h);
+    return h;
+}
+
+void writePSF(const cv::Mat& h, const std::filesystem::path& output_path)
+{
+    cv::Mat h8;
+    h.convertTo(h8, CV_8U);
+    cv::imwrite(output_path, h8);
+}
+
+// The width in pixels of the support of the PSF
+int psfExtent(const PSFParams& params)
+{
+    int extent = 0;
+    switch (params.type)
+    {
+        case PSFType::Motion:
+            extent = params.len;
+            break;
+        case PSFType::Circle:
+            extent = 2 * params.r + 1;
+            break;
+        case PSFType::MotionCircle:
+            extent = params.len + 2 * params.r + 1;
+            break;
+    }
+    return std::max(extent, 1);
+}
+}  // namespace
+
+PSFParams PSFParams::motion(int len, double theta)
+{
+    return PSFParams{ PSFType::Motion, len, theta, 0 };
+}
+
+PSFParams PSFParams::circle(int r)
+{
+    return PSFParams{ PSFType::Circle, 0, 0.0, r };
+}
+
+PSFParams PSFParams::combined(int len, double theta, int r)
+{
+    return PSFParams{ PSFType::MotionCircle, len, theta, r };
+}
+
+void calcMotionPSF(cv::Mat& outputImg, cv::Size filterSize, int len, double theta)
+{
+    cv::Mat h = drawMotionPSF(filterSize, len, theta);
+    cv::Scalar summa = cv::sum(h);
     outputImg = h / summa[0];
-    h.convertTo(h, CV_8U);
-    cv::imwrite(output_path, h);
 }
 
-void calcWnrFilter(const cv::Mat& input_h_PSF, cv::Mat& output_G, double nsr)
+void calcMotionPSF(cv::Mat& outputImg, cv::Size filterSize, const std::filesystem::path& output_path, int len, double theta)
+{
+    cv::Mat h = drawMotionPSF(filterSize, len, theta);
+    cv::Scalar summa = cv::sum(h);
+    outputImg = h / summa[0];
+    writePSF(h, output_path);
+}
+
+void calcCirclePSF(cv::Mat& outputImg, cv::Size filterSize, int r)
+{
+    cv::Mat h = drawCirclePSF(filterSize, r);
+    cv::Scalar summa = cv::sum(h);
+    outputImg = h / summa[0];
+}
+
+void calcCirclePSF(cv::Mat& outputImg, cv::Size filterSize, const std::filesystem::path& output_path, int r)
+{
+    cv::Mat h = drawCirclePSF(filterSize, r);
+    cv::Scalar summa = cv::sum(h);
+    outputImg = h / summa[0];
+    writePSF(h, output_path);
+}
+
+void calcPSF(cv::Mat& outputImg, cv::Size filterSize, const PSFParams& params)
+{
+    switch (params.type)
+    {
+        case PSFType::Motion:
+            calcMotionPSF(outputImg, filterSize, params.len, params.theta);
+            break;
+        case PSFType::Circle:
+            calcCirclePSF(outputImg, filterSize, params.r);
+            break;
+        default:
+            throw std::invalid_argument("A combined PSF is only defined by its spectrum");
+    }
+}
+
+void calcPSFSpectrum(const cv::Mat& input_h_PSF, cv::Mat& output_spectrum)
+{
+    // The PSF is real, so a real transform expanded to the full complex spectrum replaces a complex one over a zero
+    // imaginary plane
+    cv::Mat h_PSF_shifted, complexH;
+    fftshift(cv::Mat_<float>(input_h_PSF), h_PSF_shifted);
+    cv::dft(h_PSF_shifted, complexH, cv::DFT_COMPLEX_OUTPUT);
+    cv::extractChannel(complexH, output_spectrum, 0);
+}
+
+void calcWnrFilterFromSpectrum(const cv::Mat& input_spectrum, cv::Mat& output_G, double nsr)
 {
-    cv::Mat h_PSF_shifted;
-    fftshift(input_h_PSF, h_PSF_shifted);
-    cv::Mat planes[2] = { cv::Mat_<float>(h_PSF_shifted.clone()), cv::Mat::zeros(h_PSF_shifted.size(), CV_32F) };
-    cv::Mat complexI;
-    cv::merge(planes, 2, complexI);
-    cv::dft(complexI, complexI);
-    cv::split(complexI, planes);
     cv::Mat denom;
-    cv::pow(cv::abs(planes[0]), 2, denom);
+    cv::pow(cv::abs(input_spectrum), 2, denom);
     denom += nsr;
-    cv::divide(planes[0], denom, output_G);
+    cv::divide(input_spectrum, denom, output_G);
+}
+
+void packRealSpectrum(const cv::Mat& input_spectrum, cv::Mat& output_packed)
+{
+    // The spectrum of a real image is Hermitian, and a real one is even, so CCS keeps a real value at every other
+    // place and zero imaginary parts in between. Columns 0 and N/2 are packed along the rows instead.
+    int M = input_spectrum.rows;
+    int N = input_spectrum.cols;
+    cv::Mat packed = cv::Mat::zeros(M, N, CV_32F);
+    for (int i = 0; i < M; i++)
+    {
+        const float* in = input_spectrum.ptr<float>(i);
+        float* out = packed.ptr<float>(i);
+        for (int j = 1; j <= (N - 1) / 2; j++)
+        {
+            out[2 * j - 1] = in[j];
+        }
+    }
+    auto packColumn = [&](int column, int j) {
+        packed.at<float>(0, column) = input_spectrum.at<float>(0, j);
+        for (int k = 1; k <= (M - 1) / 2; k++)
+        {
+            packed.at<float>(2 * k - 1, column) = input_spectrum.at<float>(k, j);
+        }
+        if (M % 2 == 0)
+        {
+            packed.at<float>(M - 1, column) = input_spectrum.at<float>(M / 2, j);
+        }
+    };
+    packColumn(0, 0);
+    if (N % 2 == 0)
+    {
+        packColumn(N - 1, N / 2);
+    }
+    output_packed = packed;
+}
+
+int getOptimalEvenDFTSize(int n)
+{
+    int size = cv::getOptimalDFTSize(n);
+    while (size % 2 != 0)
+    {
+        size = cv::getOptimalDFTSize(size + 1);
+    }
+    return size;
+}
+
+cv::Size getPaddedDFTSize(cv::Size size, const PSFParams& params, bool pad_band)
+{
+    int band = pad_band ? 2 * psfExtent(params) : 0;
+    return cv::Size(getOptimalEvenDFTSize(size.width + band), getOptimalEvenDFTSize(size.height + band));
+}
+
+void padForDFT(const cv::Mat& inputImg, cv::Mat& outputImg, cv::Size size)
+{
+    int rows = inputImg.rows;
+    int cols = inputImg.cols;
+    cv::Mat padded(size, CV_32F);
+    inputImg.convertTo(padded(cv::Rect(0, 0, cols, rows)), CV_32F);
+    int pad_cols = size.width - cols;
+    for (int y = 0; y < rows; y++)
+    {
+        float* row = padded.ptr<float>(y);
+        for (int x = cols; x < size.width; x++)
+        {
+            float t = float(x - cols + 1) / float(pad_cols + 1);
+            row[x] = (1.0f - t) * row[cols - 1] + t * row[0];
+        }
+    }
+    int pad_rows = size.height - rows;
+    for (int y = rows; y < size.height; y++)
+    {
+        float t = float(y - rows + 1) / float(pad_rows + 1);
+        const float* last = padded.ptr<float>(rows - 1);
+        const float* first = padded.ptr<float>(0);
+        float* row = padded.ptr<float>(y);
+        for (int x = 0; x < size.width; x++)
+        {
+            row[x] = (1.0f - t) * last[x] + t * first[x];
+        }
+    }
+    outputImg = padded;
+}
+
+void calcWnrFilter(const cv::Mat& input_h_PSF, cv::Mat& output_G, double nsr)
+{
+    cv::Mat spectrum;
+    calcPSFSpectrum(input_h_PSF, spectrum);
+    calcWnrFilterFromSpectrum(spectrum, output_G, nsr);
+}
+
+FilterCache& FilterCache::instance()
+{
+    static FilterCache cache;
+    return cache;
+}
+
+FilterCache::Key FilterCache::makeKey(Kind kind, cv::Size size, const PSFParams& params, double nsr)
+{
+    return Key(kind, size.width, size.height, static_cast<int>(params.type), params.len, params.theta, params.r, nsr);
+}
+
+bool FilterCache::find(const Key& key, cv::Mat& value)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end())
+    {
+        return false;
+    }
+    entries.splice(entries.begin(), entries, it->second);
+    value = it->second->second;
+    return true;
+}
+
+void FilterCache::insert(const Key& key, const cv::Mat& value)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (capacity == 0 || index.count(key) != 0)
+    {
+        return;
+    }
+    entries.emplace_front(key, value);
+    index.emplace(key, entries.begin());
+    while (entries.size() > capacity)
+    {
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+}
+
+cv::Mat FilterCache::psfSpectrum(cv::Size size, const PSFParams& params)
+{
+    Key key = makeKey(Spectrum, size, params, 0.0);
+    cv::Mat spectrum;
+    if (find(key, spectrum))
+    {
+        return spectrum;
+    }
+    // Built outside the lock; concurrent misses on one key only build it twice
+    if (params.type == PSFType::MotionCircle)
+    {
+        cv::multiply(psfSpectrum(size, PSFParams::motion(params.len, params.theta)), psfSpectrum(size, PSFParams::circle(params.r)),
+                     spectrum);
+    }
+    else
+    {
+        cv::Mat h;
+        calcPSF(h, size, params);
+        calcPSFSpectrum(h, spectrum);
+    }
+    insert(key, spectrum);
+    return spectrum;
+}
+
+cv::Mat FilterCache::wienerFilter(cv::Size size, const PSFParams& params, double nsr)
+{
+    Key key = makeKey(Filter, size, params, nsr);
+    cv::Mat G;
+    if (find(key, G))
+    {
+        return G;
+    }
+    calcWnrFilterFromSpectrum(psfSpectrum(size, params), G, nsr);
+    insert(key, G);
+    return G;
+}
+
+cv::Mat FilterCache::packedWienerFilter(cv::Size size, const PSFParams& params, double nsr)
+{
+    Key key = makeKey(PackedFilter, size, params, nsr);
+    cv::Mat G;
+    if (find(key, G))
+    {
+        return G;
+    }
+    packRealSpectrum(wienerFilter(size, params, nsr), G);
+    insert(key, G);
+    return G;
+}
+
+cv::Mat FilterCache::packedPSFSpectrum(cv::Size size, const PSFParams& params)
+{
+    Key key = makeKey(PackedSpectrum, size, params, 0.0);
+    cv::Mat H;
+    if (find(key, H))
+    {
+        return H;
+    }
+    packRealSpectrum(psfSpectrum(size, params), H);
+    insert(key, H);
+    return H;
+}
+
+void FilterCache::setCapacity(size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    this->capacity = capacity;
+    while (entries.size() > capacity)
+    {
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+}
+
+void FilterCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+}
+
+size_t FilterCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+size_t FilterCache::getCapacity() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return capacity;
+}
+
+FilterCache::Reservation::Reservation(FilterCache& cache, size_t capacity)
+  : cache(cache),
+    previous(cache.getCapacity())
+{
+    cache.setCapacity(std::max(previous, capacity));
+}
+
+FilterCache::Reservation::~Reservation()
+{
+    cache.setCapacity(previous);
 }
 
 void edgetaper(const cv::Mat& inputImg, cv::Mat& outputImg, double gamma, double beta)
@@ -118,72 +442,344 @@ void filter2DFreq(const cv::Mat& inputImg, cv::Mat& outputImg, const cv::Mat& H)
     outputImg = planes[0];
 }
 
-void process_motion_blur(const std::filesystem::path& input_filename, const std::filesystem::path& output_filename,
-                         const std::filesystem::path& output_psf_filename, int len, double theta, double snr)
+WienerSweep::WienerSweep(const cv::Mat& inputImg, const PSFParams& params, unsigned channel_threads, bool pad_band)
+  : size(inputImg.size()),
+    padded(getPaddedDFTSize(inputImg.size(), params, pad_band)),
+    params(params),
+    channel_threads(channel_threads)
+{
+    std::vector<cv::Mat> channels;
+    cv::split(inputImg, channels);
+    // The alpha channel of a BMPImage::asMat() view is not restored
+    if (channels.size() == 4)
+    {
+        channels.pop_back();
+    }
+    spectra.resize(channels.size());
+    parallelFor(channels.size(), channel_threads, [&](size_t i) {
+        cv::Mat paddedChannel;
+        padForDFT(channels[i], paddedChannel, padded);
+        cv::dft(paddedChannel, spectra[i], cv::DFT_SCALE);
+    });
+}
+
+void WienerSweep::restore(double snr, cv::Mat& outputImg) const
+{
+    WienerScratch scratch;
+    restore(params, snr, outputImg, scratch);
+}
+
+void WienerSweep::restore(const PSFParams& psf, double snr, cv::Mat& outputImg, WienerScratch& scratch) const
+{
+    cv::Mat Hw = FilterCache::instance().packedWienerFilter(padded, psf, 1.0 / double(snr));
+
+    scratch.products.resize(spectra.size());
+    scratch.reals.resize(spectra.size());
+    scratch.channels.resize(spectra.size());
+    parallelFor(spectra.size(), channel_threads, [&](size_t i) {
+        cv::mulSpectrums(spectra[i], Hw, scratch.products[i], 0);
+        cv::idft(scratch.products[i], scratch.reals[i], cv::DFT_REAL_OUTPUT);
+        scratch.reals[i](cv::Rect(0, 0, size.width, size.height)).convertTo(scratch.channels[i], CV_8U);
+        cv::normalize(scratch.channels[i], scratch.channels[i], 0, 255, cv::NORM_MINMAX);
+    });
+    cv::merge(scratch.channels, outputImg);
+}
+
+void restoreWiener(const cv::Mat& inputImg, cv::Mat& outputImg, const PSFParams& params, double snr,
+                   unsigned channel_threads, bool pad_band)
+{
+    WienerSweep(inputImg, params, channel_threads, pad_band).restore(snr, outputImg);
+}
+
+namespace
+{
+// The margin of a tile: the Wiener filter reaches far beyond the PSF; with four PSF extents the cores stay within a
+// few gray levels of the whole-image restoration
+int tileMargin(const PSFParams& params)
+{
+    return 4 * psfExtent(params);
+}
+
+// Copies a region of the first channels of an 8-bit image into float planes, with the values padForDFT gives the
+// image padded to padded: coordinates wrap around the padded size, and past the image the bands blend the last row
+// and column into the first ones
+void extractPadded(const cv::Mat& image, cv::Size padded, cv::Rect region, int channels, std::vector<cv::Mat>& planes)
+{
+    const int rows = image.rows;
+    const int cols = image.cols;
+    const int step = image.channels();
+    planes.resize(channels);
+    for (cv::Mat& plane : planes)
+    {
+        plane.create(region.size(), CV_32F);
+    }
+    // A column of the padded image, from one row of the image
+    auto sample = [&](const uchar* source, int x, int c) {
+        if (x < cols)
+        {
+            return float(source[x * step + c]);
+        }
+        float t = float(x - cols + 1) / float(padded.width - cols + 1);
+        return (1.0f - t) * float(source[(cols - 1) * step + c]) + t * float(source[c]);
+    };
+    for (int y = 0; y < region.height; y++)
+    {
+        int source_y = ((region.y + y) % padded.height + padded.height) % padded.height;
+        const uchar* first = image.ptr(0);
+        const uchar* last = image.ptr(rows - 1);
+        const uchar* source = source_y < rows ? image.ptr(source_y) : nullptr;
+        float t = float(source_y - rows + 1) / float(padded.height - rows + 1);
+        for (int c = 0; c < channels; c++)
+        {
+            float* row = planes[c].ptr<float>(y);
+            for (int x = 0; x < region.width; x++)
+            {
+                int source_x = ((region.x + x) % padded.width + padded.width) % padded.width;
+                row[x] = source ? sample(source, source_x, c)
+                                : (1.0f - t) * sample(last, source_x, c) + t * sample(first, source_x, c);
+            }
+        }
+    }
+}
+}  // namespace
+
+void restoreWienerTiled(const cv::Mat& inputImg, cv::Mat& outputImg, const PSFParams& params, double snr, int tile_size,
+                        unsigned thread_count, bool pad_band)
 {
-    cv::Mat imgIn;
-    imgIn = cv::imread(input_filename, cv::IMREAD_COLOR);
+    if (tile_size < 1)
+    {
+        throw std::invalid_argument("Tile size must be positive");
+    }
+    // The alpha channel of a BMPImage::asMat() view is not restored
+    const int channels = std::min(inputImg.channels(), 3);
+    const int margin = tileMargin(params);
+    // A core narrower than both margins would spend most of every transform on the overlap
+    tile_size = std::max(tile_size, 2 * margin);
+    const int padded = getOptimalEvenDFTSize(tile_size + 2 * margin);
+    const int core = padded - 2 * margin;
+    const int tiles_x = (inputImg.cols + core - 1) / core;
+    const int tiles_y = (inputImg.rows + core - 1) / core;
+    // The tiles see the image as restoreWiener pads it, so the borders match the whole-image restoration
+    const cv::Size whole = getPaddedDFTSize(inputImg.size(), params, pad_band);
+    cv::Mat Hw = FilterCache::instance().packedWienerFilter(cv::Size(padded, padded), params, 1.0 / double(snr));
+
+    cv::Mat result(inputImg.size(), CV_8UC(channels));
+    std::mutex mutex;
+    std::vector<double> lows(channels, 255.0), highs(channels, 0.0);
+    parallelFor(size_t(tiles_x) * tiles_y, thread_count, [&](size_t t) {
+        int x0 = int(t % tiles_x) * core;
+        int y0 = int(t / tiles_x) * core;
+        cv::Rect core_rect(x0, y0, std::min(core, inputImg.cols - x0), std::min(core, inputImg.rows - y0));
 
-    std::vector<cv::Mat> channels(3);
-    cv::split(imgIn, channels);
+        cv::Mat real, spectrum, product;
+        std::vector<cv::Mat> planes, restored(channels);
+        extractPadded(inputImg, whole, cv::Rect(x0 - margin, y0 - margin, padded, padded), channels, planes);
+        std::vector<double> tile_lows(channels), tile_highs(channels);
+        for (int c = 0; c < channels; c++)
+        {
+            cv::dft(planes[c], spectrum, cv::DFT_SCALE);
+            cv::mulSpectrums(spectrum, Hw, product, 0);
+            cv::idft(product, real, cv::DFT_REAL_OUTPUT);
+            real(cv::Rect(margin, margin, core_rect.width, core_rect.height)).convertTo(restored[c], CV_8U);
+            cv::minMaxLoc(restored[c], &tile_lows[c], &tile_highs[c]);
+        }
+        cv::Mat target = result(core_rect);
+        cv::merge(restored, target);
 
-    std::vector<cv::Mat> processedChannels;
-    for (int i = 0; i < 3; i++)
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int c = 0; c < channels; c++)
+        {
+            lows[c] = std::min(lows[c], tile_lows[c]);
+            highs[c] = std::max(highs[c], tile_highs[c]);
+        }
+    });
+
+    // Stretch each channel to [0, 255] in place, as cv::normalize does for the whole image
+    cv::Mat lut(1, 256, CV_8UC(channels));
+    for (int c = 0; c < channels; c++)
     {
-        cv::Mat channel = channels[i].clone();
-        cv::Mat processedChannel;
+        double scale = highs[c] > lows[c] ? 255.0 / (highs[c] - lows[c]) : 0.0;
+        for (int v = 0; v < 256; v++)
+        {
+            lut.ptr<uchar>(0)[v * channels + c] = cv::saturate_cast<uchar>((v - lows[c]) * scale);
+        }
+    }
+    cv::LUT(result, lut, result);
+    outputImg = result;
+}
 
-        cv::Rect roi = cv::Rect(0, 0, channel.cols & -2, channel.rows & -2);
+int restoreRichardsonLucy(const cv::Mat& inputImg, cv::Mat& outputImg, const PSFParams& params, int iterations,
+                          double tolerance, unsigned channel_threads, bool pad_band)
+{
+    if (iterations < 1)
+    {
+        throw std::invalid_argument("Richardson-Lucy needs at least one iteration");
+    }
+    cv::Size padded = getPaddedDFTSize(inputImg.size(), params, pad_band);
+    cv::Mat H = FilterCache::instance().packedPSFSpectrum(padded, params);
 
-        cv::Mat Hw, h;
-        calcMotionPSF(h, roi.size(), output_psf_filename, len, theta);
-        calcWnrFilter(h, Hw, 1.0 / double(snr));
+    std::vector<cv::Mat> channels;
+    cv::split(inputImg, channels);
+    // The alpha channel of a BMPImage::asMat() view is not restored
+    if (channels.size() == 4)
+    {
+        channels.pop_back();
+    }
+    std::vector<cv::Mat> restored(channels.size());
+    std::vector<int> counts(channels.size(), 0);
+    parallelFor(channels.size(), channel_threads, [&](size_t i) {
+        cv::Mat observed, estimate, previous, spectrum, product, blurred, ratio;
+        padForDFT(channels[i], observed, padded);
+        observed.copyTo(estimate);
+        int k = 0;
+        while (k < iterations)
+        {
+            cv::dft(estimate, spectrum);
+            cv::mulSpectrums(spectrum, H, product, 0);
+            cv::idft(product, blurred, cv::DFT_SCALE | cv::DFT_REAL_OUTPUT);
+            // Dark regions of the estimate would divide by zero
+            cv::max(blurred, 1e-6, blurred);
+            cv::divide(observed, blurred, ratio);
 
-        channel.convertTo(channel, CV_32F);
-        // edgetaper(channel, channel, 6, 10);
-        filter2DFreq(channel(roi), processedChannel, Hw);
-        processedChannel.convertTo(processedChannel, CV_8U);
-        cv::normalize(processedChannel, processedChannel, 0, 255, cv::NORM_MINMAX);
+            cv::dft(ratio, spectrum);
+            cv::mulSpectrums(spectrum, H, product, 0, true);
+            cv::idft(product, ratio, cv::DFT_SCALE | cv::DFT_REAL_OUTPUT);
+            if (tolerance > 0.0)
+            {
+                estimate.copyTo(previous);
+            }
+            cv::multiply(estimate, ratio, estimate);
+            ++k;
+            if (tolerance > 0.0 && cv::norm(estimate, previous, cv::NORM_L1) <= tolerance * cv::norm(previous, cv::NORM_L1))
+            {
+                break;
+            }
+        }
+        estimate(cv::Rect(0, 0, inputImg.cols, inputImg.rows)).convertTo(restored[i], CV_8U);
+        counts[i] = k;
+    });
+    cv::merge(restored, outputImg);
+    return *std::max_element(counts.begin(), counts.end());
+}
 
-        processedChannels.push_back(processedChannel);
+double calcPSNR(const cv::Mat& original, const cv::Mat& processed)
+{
+    if (original.size() != processed.size() || original.type() != processed.type())
+    {
+        throw std::invalid_argument("Images must be of the same size");
     }
+    double mse = cv::norm(original, processed, cv::NORM_L2SQR) / (double(original.total()) * original.channels());
+    return 10.0 * log10(255.0 * 255.0 / mse);
+}
 
-    cv::Mat processedImage;
-    cv::merge(processedChannels, processedImage);
-    cv::imwrite(output_filename, processedImage);
+namespace
+{
+cv::Mat readColor(const std::filesystem::path& input_filename)
+{
+    cv::Mat imgIn = cv::imread(input_filename, cv::IMREAD_COLOR);
+    if (imgIn.empty())
+    {
+        throw std::runtime_error("Unable to read " + input_filename.string());
+    }
+    return imgIn;
 }
 
-void process_oof_blur(const std::filesystem::path& input_filename, const std::filesystem::path& output_filename,
-                      const std::filesystem::path& output_psf_filename, int r, double snr)
+void restoreImage(const cv::Mat& inputImg, cv::Mat& outputImg, const PSFParams& params, double snr, unsigned thread_count,
+                  int tile_size, bool pad_band)
+{
+    if (tile_size > 0)
+    {
+        restoreWienerTiled(inputImg, outputImg, params, snr, tile_size, thread_count, pad_band);
+    }
+    else
+    {
+        restoreWiener(inputImg, outputImg, params, snr, thread_count, pad_band);
+    }
+}
+}  // namespace
+
+void process_motion_blur(const cv::Mat& inputImg, cv::Mat& outputImg, const std::filesystem::path& output_psf_filename,
+                         int len, double theta, double snr, unsigned thread_count, int tile_size, bool pad_band)
 {
-    cv::Mat imgIn;
-    imgIn = cv::imread(input_filename, cv::IMREAD_COLOR);
+    restoreImage(inputImg, outputImg, PSFParams::motion(len, theta), snr, thread_count, tile_size, pad_band);
+    if (!output_psf_filename.empty())
+    {
+        cv::Mat h;
+        calcMotionPSF(h, outputImg.size(), output_psf_filename, len, theta);
+    }
+}
 
-    std::vector<cv::Mat> channels(3);
-    cv::split(imgIn, channels);
+void process_motion_blur(const std::filesystem::path& input_filename, const std::filesystem::path& output_filename,
+                         const std::filesystem::path& output_psf_filename, int len, double theta, double snr,
+                         unsigned thread_count, int tile_size, bool pad_band)
+{
+    cv::Mat processedImage;
+    process_motion_blur(readColor(input_filename), processedImage, output_psf_filename, len, theta, snr, thread_count,
+                        tile_size, pad_band);
+    cv::imwrite(output_filename, processedImage);
+}
 
-    std::vector<cv::Mat> processedChannels;
-    for (int i = 0; i < 3; i++)
+void process_oof_blur(const cv::Mat& inputImg, cv::Mat& outputImg, const std::filesystem::path& output_psf_filename, int r,
+                      double snr, unsigned thread_count, int tile_size, bool pad_band)
+{
+    restoreImage(inputImg, outputImg, PSFParams::circle(r), snr, thread_count, tile_size, pad_band);
+    if (!output_psf_filename.empty())
     {
-        cv::Mat channel = channels[i].clone();
-        cv::Mat processedChannel;
+        cv::Mat h;
+        calcCirclePSF(h, outputImg.size(), output_psf_filename, r);
+    }
+}
 
-        cv::Rect roi = cv::Rect(0, 0, channel.cols & -2, channel.rows & -2);
+void process_oof_blur(const std::filesystem::path& input_filename, const std::filesystem::path& output_filename,
+                      const std::filesystem::path& output_psf_filename, int r, double snr, unsigned thread_count,
+                      int tile_size, bool pad_band)
+{
+    cv::Mat processedImage;
+    process_oof_blur(readColor(input_filename), processedImage, output_psf_filename, r, snr, thread_count, tile_size,
+                     pad_band);
+    cv::imwrite(output_filename, processedImage);
+}
 
-        cv::Mat Hw, h;
-        calcCirclePSF(h, roi.size(), output_psf_filename, r);
-        calcWnrFilter(h, Hw, 1.0 / double(snr));
+void process_fused_blur(const cv::Mat& inputImg, cv::Mat& outputImg, int len, double theta, int r, double snr,
+                        unsigned thread_count, int tile_size, bool pad_band)
+{
+    restoreImage(inputImg, outputImg, PSFParams::combined(len, theta, r), snr, thread_count, tile_size, pad_band);
+}
 
-        channel.convertTo(channel, CV_32F);
-        // edgetaper(channel, channel, 5, 10);
-        filter2DFreq(channel(roi), processedChannel, Hw);
-        processedChannel.convertTo(processedChannel, CV_8U);
-        cv::normalize(processedChannel, processedChannel, 0, 255, cv::NORM_MINMAX);
+void process_fused_blur(const std::filesystem::path& input_filename, const std::filesystem::path& output_filename, int len,
+                        double theta, int r, double snr, unsigned thread_count, int tile_size, bool pad_band)
+{
+    cv::Mat processedImage;
+    process_fused_blur(readColor(input_filename), processedImage, len, theta, r, snr, thread_count, tile_size, pad_band);
+    cv::imwrite(output_filename, processedImage);
+}
 
-        processedChannels.push_back(processedChannel);
+int process_rl_blur(const cv::Mat& inputImg, cv::Mat& outputImg, const std::filesystem::path& output_psf_filename,
+                    const PSFParams& psf, int iterations, double tolerance, unsigned thread_count, bool pad_band)
+{
+    int performed = restoreRichardsonLucy(inputImg, outputImg, psf, iterations, tolerance, thread_count, pad_band);
+    if (!output_psf_filename.empty() && psf.type != PSFType::MotionCircle)
+    {
+        cv::Mat h;
+        if (psf.type == PSFType::Motion)
+        {
+            calcMotionPSF(h, outputImg.size(), output_psf_filename, psf.len, psf.theta);
+        }
+        else
+        {
+            calcCirclePSF(h, outputImg.size(), output_psf_filename, psf.r);
+        }
     }
+    return performed;
+}
 
+int process_rl_blur(const std::filesystem::path& input_filename, const std::filesystem::path& output_filename,
+                    const std::filesystem::path& output_psf_filename, const PSFParams& psf, int iterations,
+                    double tolerance, unsigned thread_count, bool pad_band)
+{
     cv::Mat processedImage;
-    cv::merge(processedChannels, processedImage);
+    int performed = process_rl_blur(readColor(input_filename), processedImage, output_psf_filename, psf, iterations,
+                                    tolerance, thread_count, pad_band);
     cv::imwrite(output_filename, processedImage);
+    return performed;
 }
@@ -1,25 +1,232 @@
 #ifndef RESTORE_CV_H
 #define RESTORE_CV_H
 
+#include <stddef.h>
+
 #include <filesystem>
+#include <list>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
 
+#include "opencv2/core/mat.hpp"
 #include "opencv2/core/types.hpp"
 
-namespace cv
+enum class PSFType
+{
+    Motion,
+    Circle,
+    // Motion blur followed by defocus: the product of both transfer functions
+    MotionCircle
+};
+
+/**
+ * @brief The parameters of a point spread function: len and theta for a motion PSF, r for a circle PSF, and all
+ * three for a combined one.
+ */
+struct PSFParams
 {
-class Mat;
-}
+    PSFType type;
+    int len;
+    double theta;
+    int r;
+
+    static PSFParams motion(int len, double theta);
+    static PSFParams circle(int r);
+    static PSFParams combined(int len, double theta, int r);
+};
 
+void calcMotionPSF(cv::Mat& outputImg, cv::Size filterSize, int len, double theta);
 void calcMotionPSF(cv::Mat& outputImg, cv::Size filterSize, const std::filesystem::path& output_path, int len, double theta);
+void calcCirclePSF(cv::Mat& outputImg, cv::Size filterSize, int r);
 void calcCirclePSF(cv::Mat& outputImg, cv::Size filterSize, const std::filesystem::path& output_path, int r);
+void calcPSF(cv::Mat& outputImg, cv::Size filterSize, const PSFParams& params);
+void calcPSFSpectrum(const cv::Mat& input_h_PSF, cv::Mat& output_spectrum);
+void calcWnrFilterFromSpectrum(const cv::Mat& input_spectrum, cv::Mat& output_G, double nsr);
+// Packs a real spectrum in the CCS layout of the DFT of a real image, for mulSpectrums on packed spectra
+void packRealSpectrum(const cv::Mat& input_spectrum, cv::Mat& output_packed);
+// The smallest even size of at least n that getOptimalDFTSize accepts; fftshift needs even sizes
+int getOptimalEvenDFTSize(int n);
+// The even fast DFT size of an image. With pad_band, it leaves room for a band of twice the PSF extent on each axis,
+// so that padForDFT gives the PSF a smooth band to blur across instead of wrapping the opposite border into the image
+cv::Size getPaddedDFTSize(cv::Size size, const PSFParams& params, bool pad_band);
+// Pads to size with bands that blend the last row and column into the first ones, so the periodic image has no edges
+void padForDFT(const cv::Mat& inputImg, cv::Mat& outputImg, cv::Size size);
 void fftshift(const cv::Mat& inputImg, cv::Mat& outputImg);
 void filter2DFreq(const cv::Mat& inputImg, cv::Mat& outputImg, const cv::Mat& H);
 void calcWnrFilter(const cv::Mat& input_h_PSF, cv::Mat& output_G, double nsr);
 void edgetaper(const cv::Mat& inputImg, cv::Mat& outputImg, double gamma = 5.0, double beta = 0.2);
 
+/**
+ * @brief A bounded LRU cache of PSF spectra and Wiener filters, shared by every channel, image and call.
+ * The spectrum of a PSF depends on the filter size and the PSF parameters only, and a Wiener filter on those and the
+ * nsr, so same-sized frames restored with the same parameters reuse one filter instead of redrawing the PSF and
+ * running its DFT per channel. Lookups are thread-safe; the returned matrices are shared and must not be modified.
+ */
+class FilterCache
+{
+  public:
+    static FilterCache& instance();
+
+    cv::Mat psfSpectrum(cv::Size size, const PSFParams& params);
+    cv::Mat wienerFilter(cv::Size size, const PSFParams& params, double nsr);
+    // The Wiener filter in the CCS layout
+    cv::Mat packedWienerFilter(cv::Size size, const PSFParams& params, double nsr);
+    // The PSF spectrum in the CCS layout
+    cv::Mat packedPSFSpectrum(cv::Size size, const PSFParams& params);
+
+    void setCapacity(size_t capacity);
+    void clear();
+    size_t size() const;
+    size_t getCapacity() const;
+
+    /**
+     * @brief Raises the capacity of the cache to at least a given size while it is in scope, for a run that must
+     * keep that many entries cached; the previous capacity is restored when it goes out of scope. Nested reservations
+     * are released in reverse order.
+     */
+    class Reservation
+    {
+      public:
+        Reservation(FilterCache& cache, size_t capacity);
+        ~Reservation();
+        Reservation(const Reservation&) = delete;
+        Reservation& operator=(const Reservation&) = delete;
+
+      private:
+        FilterCache& cache;
+        size_t previous;
+    };
+
+  private:
+    enum Kind
+    {
+        Spectrum,
+        Filter,
+        PackedFilter,
+        PackedSpectrum
+    };
+    // kind, width, height, type, len, theta, r, nsr
+    using Key = std::tuple<int, int, int, int, int, double, int, double>;
+
+    static Key makeKey(Kind kind, cv::Size size, const PSFParams& params, double nsr);
+    bool find(const Key& key, cv::Mat& value);
+    void insert(const Key& key, const cv::Mat& value);
+
+    mutable std::mutex mutex;
+    size_t capacity = 64;
+    std::list<std::pair<Key, cv::Mat>> entries;
+    std::map<Key, std::list<std::pair<Key, cv::Mat>>::iterator> index;
+};
+
+// The buffers of WienerSweep::restore, kept between calls to avoid reallocating them; one of each per channel, so
+// that the channels can be restored concurrently
+struct WienerScratch
+{
+    std::vector<cv::Mat> products;
+    std::vector<cv::Mat> reals;
+    std::vector<cv::Mat> channels;
+};
+
+/**
+ * @brief Wiener restoration of one image for many snr values. The channel spectra are computed once and the PSF
+ * spectrum comes from the filter cache, so each snr only costs the per-frequency product and the inverse DFTs.
+ * The channels are padded to getPaddedDFTSize for the PSF of params and transformed as real images (CCS), and the
+ * output is cropped back to the input size with each channel stretched to [0, 255]. The spectra do not depend on the
+ * PSF, so other PSFs can be swept over the same object, and restore is safe to call from several threads with one
+ * scratch per thread; with pad_band, a sweep is built for its largest PSF, as smaller ones fit in its band.
+ * With channel_threads other than 1, the channels are transformed and restored concurrently (0: up to one thread per
+ * channel); callers that already run one sweep per core keep the default of 1.
+ */
+class WienerSweep
+{
+  public:
+    WienerSweep(const cv::Mat& inputImg, const PSFParams& params, unsigned channel_threads = 1, bool pad_band = false);
+
+    void restore(double snr, cv::Mat& outputImg) const;
+    void restore(const PSFParams& psf, double snr, cv::Mat& outputImg, WienerScratch& scratch) const;
+
+  private:
+    cv::Size size;
+    cv::Size padded;
+    PSFParams params;
+    unsigned channel_threads;
+    std::vector<cv::Mat> spectra;
+};
+
+// Restores the channels concurrently unless channel_threads is 1
+void restoreWiener(const cv::Mat& inputImg, cv::Mat& outputImg, const PSFParams& params, double snr,
+                   unsigned channel_threads = 0, bool pad_band = false);
+
+/**
+ * @brief The Wiener restoration of restoreWiener in overlapping tiles (overlap-save), for images too large to
+ * transform at once. Every tile is transformed with a margin of four PSF extents on each side, and only its core is
+ * kept; the tiles are a fast DFT size and share one cached filter. Past the image borders the margins take the values
+ * of the image padded by padForDFT to the getPaddedDFTSize of restoreWiener with the same pad_band, repeated
+ * periodically, so the borders are restored as the whole image would be. The tiles run in parallel and are written
+ * straight into the output, so apart from the input and the output the memory is a few tile-sized buffers per thread.
+ * The result differs from the whole-image restoration by at most a few gray levels, where the margin cuts off the
+ * tail of the Wiener filter.
+ *
+ * @param tile_size The minimum core size of a tile in pixels; the cores grow to the next fast DFT size. Sizes below
+ * twice the margin are raised to it, so that at least half of every tile transform is core: for a motion length of
+ * 30 the margin is 120 pixels and the cores are at least 240.
+ * @param thread_count The number of tiles restored at once, or 0 for one per core.
+ */
+void restoreWienerTiled(const cv::Mat& inputImg, cv::Mat& outputImg, const PSFParams& params, double snr, int tile_size,
+                        unsigned thread_count = 0, bool pad_band = false);
+
+/**
+ * @brief Richardson-Lucy deconvolution, which keeps the image non-negative and rings much less than the Wiener filter
+ * around saturated highlights. Each iteration blurs the estimate with the PSF, divides the input by it and multiplies
+ * the estimate by that ratio correlated with the PSF. The PSF spectrum comes from the filter cache in the CCS layout;
+ * the PSFs are point-symmetric with a real spectrum, so the flipped PSF of the correlation shares it. Every channel
+ * works in float in buffers that the first iteration allocates, so an iteration costs two forward and two inverse real
+ * DFTs and a few element-wise passes. The channels are restored concurrently unless channel_threads is 1.
+ *
+ * @param iterations The maximum number of iterations.
+ * @param tolerance Stops a channel once an iteration changes it by at most this fraction (L1); 0 runs every iteration.
+ * @return The largest number of iterations run on a channel.
+ */
+int restoreRichardsonLucy(const cv::Mat& inputImg, cv::Mat& outputImg, const PSFParams& params, int iterations,
+                          double tolerance = 0.0, unsigned channel_threads = 0, bool pad_band = false);
+
+// The PSNR of PSNR::calculatePSNR, for images in memory
+double calcPSNR(const cv::Mat& original, const cv::Mat& processed);
+
+// An empty PSF file name skips writing the PSF image. With a tile size, the image is restored in tiles by
+// restoreWienerTiled and thread_count bounds the tiles in flight; otherwise it bounds the channels restored at once.
+// pad_band pads the whole-image transforms by a band of twice the PSF extent (see getPaddedDFTSize).
 void process_motion_blur(const std::filesystem::path& input_filename, const std::filesystem::path& output_filename,
-                         const std::filesystem::path& output_psf_filename, int len, double theta, double snr);
+                         const std::filesystem::path& output_psf_filename, int len, double theta, double snr,
+                         unsigned thread_count = 0, int tile_size = 0, bool pad_band = false);
 
 void process_oof_blur(const std::filesystem::path& input_filename, const std::filesystem::path& output_filename,
-                      const std::filesystem::path& output_psf_filename, int r, double snr);
+                      const std::filesystem::path& output_psf_filename, int r, double snr, unsigned thread_count = 0,
+                      int tile_size = 0, bool pad_band = false);
+
+// Restores motion blur and defocus in one pass, with one Wiener filter for the combined PSF, in float until the end
+void process_fused_blur(const std::filesystem::path& input_filename, const std::filesystem::path& output_filename, int len,
+                        double theta, int r, double snr, unsigned thread_count = 0, int tile_size = 0,
+                        bool pad_band = false);
+
+// Restores any PSF with restoreRichardsonLucy; the PSF image is written for motion and circle PSFs only
+int process_rl_blur(const std::filesystem::path& input_filename, const std::filesystem::path& output_filename,
+                    const std::filesystem::path& output_psf_filename, const PSFParams& psf, int iterations,
+                    double tolerance = 0.0, unsigned thread_count = 0, bool pad_band = false);
+
+// The same restorations on images in memory, so that stages can be chained without files; only the PSF image is
+// written. The output has no alpha channel.
+void process_motion_blur(const cv::Mat& inputImg, cv::Mat& outputImg, const std::filesystem::path& output_psf_filename,
+                         int len, double theta, double snr, unsigned thread_count = 0, int tile_size = 0,
+                         bool pad_band = false);
+void process_oof_blur(const cv::Mat& inputImg, cv::Mat& outputImg, const std::filesystem::path& output_psf_filename, int r,
+                      double snr, unsigned thread_count = 0, int tile_size = 0, bool pad_band = false);
+void process_fused_blur(const cv::Mat& inputImg, cv::Mat& outputImg, int len, double theta, int r, double snr,
+                        unsigned thread_count = 0, int tile_size = 0, bool pad_band = false);
+int process_rl_blur(const cv::Mat& inputImg, cv::Mat& outputImg, const std::filesystem::path& output_psf_filename,
+                    const PSFParams& psf, int iterations, double tolerance = 0.0, unsigned thread_count = 0,
+                    bool pad_band = false);
 #endif  // RESTORE_CV_H
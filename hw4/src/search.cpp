@@ -0,0 +1,530 @@
+/**
+ * @file search.cpp
+ * @brief The implementation of the search strategies for the restoration parameters.
+ * @version 0.1
+ * @date 2023-12-18
+ *
+ */
+
+#include "search.h"
+
+#include <math.h>
+#include <stddef.h>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include "parallel.h"
+
+namespace
+{
+// A candidate as a point: len, theta, snr1, r, snr2
+using Point = std::array<double, 5>;
+
+std::array<ParamRange, 5> axesOf(const SweepRanges& ranges)
+{
+    return { ranges.len, ranges.theta, ranges.snr1, ranges.r, ranges.snr2 };
+}
+
+SweepRanges rangesOf(const std::array<ParamRange, 5>& axes)
+{
+    return SweepRanges{ axes[0], axes[1], axes[2], axes[3], axes[4] };
+}
+
+bool isInteger(size_t axis)
+{
+    return axis == 0 || axis == 3;
+}
+
+RestoreParams toParams(const Point& point)
+{
+    return RestoreParams{ int(lround(point[0])), point[1], point[2], int(lround(point[3])), point[4] };
+}
+
+Point toPoint(const RestoreParams& params)
+{
+    return { double(params.len), params.theta, params.snr1, double(params.r), params.snr2 };
+}
+
+Point center(const std::array<ParamRange, 5>& axes)
+{
+    Point point;
+    for (size_t k = 0; k < axes.size(); k++)
+    {
+        point[k] = 0.5 * (axes[k].first + axes[k].last);
+    }
+    return point;
+}
+
+/**
+ * @brief The PSNR objective for the sequential searches. Every candidate is restored once: a point that rounds to
+ * a candidate already seen is answered from memory.
+ */
+class Objective
+{
+  public:
+    Objective(const ParameterSweep& sweep, const std::function<void(const SweepResult&)>& on_result)
+      : sweep(sweep), on_result(on_result)
+    {
+    }
+
+    double operator()(const Point& point)
+    {
+        RestoreParams params = toParams(point);
+        auto key = std::make_tuple(params.len, params.theta, params.snr1, params.r, params.snr2);
+        auto it = memo.find(key);
+        if (it != memo.end())
+        {
+            return it->second;
+        }
+        SweepResult result{ params, sweep.evaluate(params, scratch) };
+        memo.emplace(key, result.psnr);
+        if (on_result)
+        {
+            on_result(result);
+        }
+        if (result.psnr > best.psnr)
+        {
+            best = result;
+        }
+        return result.psnr;
+    }
+
+    const SweepResult& getBest() const
+    {
+        return best;
+    }
+
+  private:
+    const ParameterSweep& sweep;
+    const std::function<void(const SweepResult&)>& on_result;
+    std::map<std::tuple<int, double, double, int, double>, double> memo;
+    SweepScratch scratch;
+    SweepResult best{ RestoreParams{ 0, 0.0, 0.0, 0, 0.0 }, -std::numeric_limits<double>::infinity() };
+};
+
+/**
+ * @brief Brent's method for the maximum of f on [a, b], to within tol.
+ */
+template <typename Function>
+void brentMaximize(Function f, double a, double b, double tol)
+{
+    const double golden = 0.3819660112501051;
+    double x = a + golden * (b - a);
+    double w = x, v = x;
+    // Brent minimizes, so the PSNR is negated
+    double fx = -f(x);
+    double fw = fx, fv = fx;
+    double d = 0.0, e = 0.0;
+    for (int iteration = 0; iteration < 100; iteration++)
+    {
+        double m = 0.5 * (a + b);
+        double tol1 = 1e-10 * fabs(x) + tol;
+        double tol2 = 2.0 * tol1;
+        if (fabs(x - m) <= tol2 - 0.5 * (b - a))
+        {
+            return;
+        }
+        bool golden_step = true;
+        if (fabs(e) > tol1)
+        {
+            // Parabola through x, w and v
+            double r = (x - w) * (fx - fv);
+            double q = (x - v) * (fx - fw);
+            double p = (x - v) * q - (x - w) * r;
+            q = 2.0 * (q - r);
+            if (q > 0.0)
+            {
+                p = -p;
+            }
+            else
+            {
+                q = -q;
+            }
+            double previous_e = e;
+            e = d;
+            if (fabs(p) < fabs(0.5 * q * previous_e) && p > q * (a - x) && p < q * (b - x))
+            {
+                d = p / q;
+                double u = x + d;
+                if (u - a < tol2 || b - u < tol2)
+                {
+                    d = copysign(tol1, m - x);
+                }
+                golden_step = false;
+            }
+        }
+        if (golden_step)
+        {
+            e = (x >= m) ? a - x : b - x;
+            d = golden * e;
+        }
+        double u = (fabs(d) >= tol1) ? x + d : x + copysign(tol1, d);
+        double fu = -f(u);
+        if (fu <= fx)
+        {
+            (u >= x ? a : b) = x;
+            v = w;
+            fv = fw;
+            w = x;
+            fw = fx;
+            x = u;
+            fx = fu;
+        }
+        else
+        {
+            (u < x ? a : b) = u;
+            if (fu <= fw || w == x)
+            {
+                v = w;
+                fv = fw;
+                w = u;
+                fw = fu;
+            }
+            else if (fu <= fv || v == x || v == w)
+            {
+                v = u;
+                fv = fu;
+            }
+        }
+    }
+}
+}  // namespace
+
+SearchMethod parseSearchMethod(const std::string& text)
+{
+    if (text == "grid")
+    {
+        return SearchMethod::Grid;
+    }
+    if (text == "coarse-to-fine")
+    {
+        return SearchMethod::CoarseToFine;
+    }
+    if (text == "brent")
+    {
+        return SearchMethod::Brent;
+    }
+    if (text == "nelder-mead")
+    {
+        return SearchMethod::NelderMead;
+    }
+    throw std::invalid_argument("Unknown search method: " + text);
+}
+
+SweepResult searchCoarseToFine(const ParameterSweep& sweep, const SweepRanges& ranges, unsigned thread_count,
+                               const std::function<void(const SweepResult&)>& on_result, int points)
+{
+    if (points < 2)
+    {
+        throw std::invalid_argument("A coarse grid needs at least 2 points per axis");
+    }
+    // Each level is a window [lo, hi] and a stride, in steps of the range
+    const std::array<ParamRange, 5> axes = axesOf(ranges);
+    std::array<std::vector<double>, 5> values;
+    std::array<size_t, 5> count, lo, hi, stride;
+    for (size_t k = 0; k < axes.size(); k++)
+    {
+        values[k] = axes[k].values();
+        count[k] = values[k].size();
+        lo[k] = 0;
+        hi[k] = count[k] - 1;
+        stride[k] = std::max<size_t>(1, (count[k] - 1 + points - 2) / (points - 1));
+    }
+
+    // The windows overlap, so the candidates are remembered by their indices on the grid of the ranges, and each
+    // thread keeps its scratch from one level to the next
+    thread_count = resolveThreadCount(thread_count, std::numeric_limits<size_t>::max());
+    std::set<std::array<size_t, 5>> seen;
+    std::vector<SweepScratch> scratches(thread_count);
+    // The defocus filters are shared by every stage and must stay cached for the whole search
+    FilterCache::Reservation reservation(FilterCache::instance(), count[3] * (count[4] + 1) + 4 * size_t(thread_count));
+    std::mutex mutex;
+    SweepResult best{ RestoreParams{ 0, 0.0, 0.0, 0, 0.0 }, -std::numeric_limits<double>::infinity() };
+    std::array<size_t, 5> best_index{};
+    while (true)
+    {
+        // The new candidates of this level in sweep order, snr2 innermost, split into runs that share a motion stage
+        std::vector<std::array<size_t, 5>> candidates;
+        std::vector<size_t> stages;
+        std::array<size_t, 5> index = lo;
+        while (index[0] <= hi[0])
+        {
+            if (seen.insert(index).second)
+            {
+                if (candidates.empty() || !std::equal(index.begin(), index.begin() + 3, candidates.back().begin()))
+                {
+                    stages.push_back(candidates.size());
+                }
+                candidates.push_back(index);
+            }
+            size_t k = axes.size() - 1;
+            while (k > 0 && index[k] + stride[k] > hi[k])
+            {
+                index[k] = lo[k];
+                k--;
+            }
+            index[k] += stride[k];
+        }
+        stages.push_back(candidates.size());
+
+        parallelFor(stages.size() - 1, thread_count, [&](size_t s, unsigned worker) {
+            for (size_t i = stages[s]; i < stages[s + 1]; i++)
+            {
+                const std::array<size_t, 5>& at = candidates[i];
+                RestoreParams params{ int(lround(values[0][at[0]])), values[1][at[1]], values[2][at[2]],
+                                      int(lround(values[3][at[3]])), values[4][at[4]] };
+                SweepResult result{ params, sweep.evaluate(params, scratches[worker]) };
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if (on_result)
+                {
+                    on_result(result);
+                }
+                if (result.psnr > best.psnr || (result.psnr == best.psnr && at < best_index))
+                {
+                    best = result;
+                    best_index = at;
+                }
+            }
+        });
+        if (std::all_of(stride.begin(), stride.end(), [](size_t s) { return s == 1; }))
+        {
+            return best;
+        }
+
+        // The next window reaches the neighbours of the best value so far
+        for (size_t k = 0; k < axes.size(); k++)
+        {
+            lo[k] = best_index[k] > stride[k] ? best_index[k] - stride[k] : 0;
+            hi[k] = std::min(count[k] - 1, best_index[k] + stride[k]);
+            stride[k] = (stride[k] + 1) / 2;
+        }
+    }
+}
+
+SweepResult searchBrent(const ParameterSweep& sweep, const SweepRanges& ranges,
+                        const std::function<void(const SweepResult&)>& on_result, int max_cycles)
+{
+    const std::array<ParamRange, 5> axes = axesOf(ranges);
+    Objective objective(sweep, on_result);
+    Point point = center(axes);
+    objective(point);
+    for (int cycle = 0; cycle < max_cycles; cycle++)
+    {
+        double before = objective.getBest().psnr;
+        for (size_t k = 0; k < axes.size(); k++)
+        {
+            if (axes[k].last <= axes[k].first)
+            {
+                continue;
+            }
+            auto along = [&](double value) {
+                Point moved = point;
+                moved[k] = value;
+                return objective(moved);
+            };
+            if (isInteger(k))
+            {
+                for (double value : axes[k].values())
+                {
+                    along(value);
+                }
+            }
+            else
+            {
+                brentMaximize(along, axes[k].first, axes[k].last, 0.5 * axes[k].step);
+            }
+            point = toPoint(objective.getBest().params);
+        }
+        if (objective.getBest().psnr <= before)
+        {
+            break;
+        }
+    }
+    return objective.getBest();
+}
+
+SweepResult searchNelderMead(const ParameterSweep& sweep, const SweepRanges& ranges,
+                             const std::function<void(const SweepResult&)>& on_result, int max_evaluations)
+{
+    const std::array<ParamRange, 5> axes = axesOf(ranges);
+    Objective objective(sweep, on_result);
+    std::vector<size_t> active;
+    for (size_t k = 0; k < axes.size(); k++)
+    {
+        if (axes[k].last > axes[k].first)
+        {
+            active.push_back(k);
+        }
+    }
+    const size_t n = active.size();
+
+    // The simplex lives in [0, 1] per active axis; Nelder-Mead minimizes, so the PSNR is negated
+    int evaluations = 0;
+    auto value = [&](std::vector<double>& u) {
+        Point point = center(axes);
+        for (size_t i = 0; i < n; i++)
+        {
+            u[i] = std::clamp(u[i], 0.0, 1.0);
+            const ParamRange& axis = axes[active[i]];
+            point[active[i]] = axis.first + u[i] * (axis.last - axis.first);
+        }
+        evaluations++;
+        return -objective(point);
+    };
+
+    auto along = [&](const std::vector<double>& from, const std::vector<double>& to, double t) {
+        std::vector<double> u(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            u[i] = from[i] + t * (to[i] - from[i]);
+        }
+        return u;
+    };
+
+    // Restarted from the best candidate until a restart no longer improves it, as rounding len and r leaves plateaus
+    // that stall a simplex
+    const double size = 0.25;
+    std::vector<double> start(n, 0.5);
+    double before;
+    do
+    {
+        before = objective.getBest().psnr;
+        std::vector<std::vector<double>> simplex(n + 1);
+        std::vector<double> f(n + 1);
+        for (size_t j = 0; j <= n; j++)
+        {
+            simplex[j] = start;
+            if (j > 0)
+            {
+                const ParamRange& axis = axes[active[j - 1]];
+                double offset = std::max(size, axis.step / (axis.last - axis.first));
+                simplex[j][j - 1] += (start[j - 1] + offset <= 1.0) ? offset : -offset;
+            }
+            f[j] = value(simplex[j]);
+        }
+
+        while (n > 0 && evaluations < max_evaluations)
+        {
+            std::vector<size_t> order(n + 1);
+            for (size_t j = 0; j <= n; j++)
+            {
+                order[j] = j;
+            }
+            std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return f[a] < f[b]; });
+            std::vector<std::vector<double>> sorted_simplex;
+            std::vector<double> sorted_f;
+            for (size_t j : order)
+            {
+                sorted_simplex.push_back(simplex[j]);
+                sorted_f.push_back(f[j]);
+            }
+            simplex.swap(sorted_simplex);
+            f.swap(sorted_f);
+
+            // Done once every vertex is within a step of the best one on every axis
+            bool converged = true;
+            for (size_t j = 1; j <= n && converged; j++)
+            {
+                for (size_t i = 0; i < n; i++)
+                {
+                    const ParamRange& axis = axes[active[i]];
+                    if (fabs(simplex[j][i] - simplex[0][i]) * (axis.last - axis.first) >= axis.step)
+                    {
+                        converged = false;
+                        break;
+                    }
+                }
+            }
+            if (converged)
+            {
+                break;
+            }
+
+            std::vector<double> centroid(n, 0.0);
+            for (size_t j = 0; j < n; j++)
+            {
+                for (size_t i = 0; i < n; i++)
+                {
+                    centroid[i] += simplex[j][i] / double(n);
+                }
+            }
+            std::vector<double>& worst = simplex[n];
+            std::vector<double> reflected = along(centroid, worst, -1.0);
+            double f_reflected = value(reflected);
+            if (f_reflected < f[0])
+            {
+                std::vector<double> expanded = along(centroid, worst, -2.0);
+                double f_expanded = value(expanded);
+                if (f_expanded < f_reflected)
+                {
+                    worst = expanded;
+                    f[n] = f_expanded;
+                }
+                else
+                {
+                    worst = reflected;
+                    f[n] = f_reflected;
+                }
+            }
+            else if (f_reflected < f[n - 1])
+            {
+                worst = reflected;
+                f[n] = f_reflected;
+            }
+            else
+            {
+                bool outside = f_reflected < f[n];
+                std::vector<double> contracted = outside ? along(centroid, reflected, 0.5) : along(centroid, worst, 0.5);
+                double f_contracted = value(contracted);
+                if (f_contracted < std::min(f_reflected, f[n]))
+                {
+                    worst = contracted;
+                    f[n] = f_contracted;
+                }
+                else
+                {
+                    // Shrink towards the best vertex
+                    for (size_t j = 1; j <= n; j++)
+                    {
+                        simplex[j] = along(simplex[0], simplex[j], 0.5);
+                        f[j] = value(simplex[j]);
+                    }
+                }
+            }
+        }
+
+        Point best = toPoint(objective.getBest().params);
+        for (size_t i = 0; i < n; i++)
+        {
+            const ParamRange& axis = axes[active[i]];
+            start[i] = (best[active[i]] - axis.first) / (axis.last - axis.first);
+        }
+    } while (n > 0 && evaluations < max_evaluations && objective.getBest().psnr > before);
+    return objective.getBest();
+}
+
+SweepResult searchParameters(const ParameterSweep& sweep, const SweepRanges& ranges, SearchMethod method,
+                             unsigned thread_count, const std::function<void(const SweepResult&)>& on_result)
+{
+    switch (method)
+    {
+        case SearchMethod::CoarseToFine:
+            return searchCoarseToFine(sweep, ranges, thread_count, on_result);
+        case SearchMethod::Brent:
+            return searchBrent(sweep, ranges, on_result);
+        case SearchMethod::NelderMead:
+            return searchNelderMead(sweep, ranges, on_result);
+        case SearchMethod::Grid:
+        default:
+            return sweep.run(ranges, thread_count, on_result);
+    }
+}
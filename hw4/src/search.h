@@ -0,0 +1,56 @@
+/**
+ * @file search.h
+ * @brief Search strategies for the restoration parameters that need far fewer restorations than the full grid:
+ * coarse-to-fine grid refinement, Brent's method per axis and Nelder-Mead. All of them maximize the PSNR objective
+ * of ParameterSweep within the given ranges, and the step of each range is the resolution they stop at.
+ * @version 0.1
+ * @date 2023-12-18
+ *
+ */
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <functional>
+#include <string>
+
+#include "sweep.h"
+
+enum class SearchMethod
+{
+    Grid,
+    CoarseToFine,
+    Brent,
+    NelderMead
+};
+
+// Parses grid, coarse-to-fine, brent or nelder-mead
+SearchMethod parseSearchMethod(const std::string& text);
+
+/**
+ * @brief Evaluates grids of about points values per axis, each one centered on the best candidate of the previous
+ * one and twice as fine, until the grid reaches the steps of the ranges. The grids run in parallel; every value lies
+ * on the grid of the ranges, and a candidate that two grids share is restored and reported once.
+ */
+SweepResult searchCoarseToFine(const ParameterSweep& sweep, const SweepRanges& ranges, unsigned thread_count = 0,
+                               const std::function<void(const SweepResult&)>& on_result = {}, int points = 5);
+
+/**
+ * @brief Maximizes along one axis at a time with Brent's method (golden-section steps with parabolic interpolation),
+ * starting from the center of the ranges, and cycles over the axes until a cycle no longer improves the PSNR. len and
+ * r are integers and are scanned instead.
+ */
+SweepResult searchBrent(const ParameterSweep& sweep, const SweepRanges& ranges,
+                        const std::function<void(const SweepResult&)>& on_result = {}, int max_cycles = 4);
+
+/**
+ * @brief Maximizes with the Nelder-Mead simplex over every axis whose range is not a single value, in coordinates
+ * scaled to the ranges; len and r are rounded. Stops when the simplex is smaller than the range steps.
+ */
+SweepResult searchNelderMead(const ParameterSweep& sweep, const SweepRanges& ranges,
+                             const std::function<void(const SweepResult&)>& on_result = {}, int max_evaluations = 200);
+
+SweepResult searchParameters(const ParameterSweep& sweep, const SweepRanges& ranges, SearchMethod method,
+                             unsigned thread_count = 0, const std::function<void(const SweepResult&)>& on_result = {});
+
+#endif  // SEARCH_H
@@ -0,0 +1,199 @@
+/**
+ * @file sweep.cpp
+ * @brief The implementation of the parameter sweep of the two-stage restoration.
+ * @version 0.1
+ * @date 2023-12-18
+ *
+ */
+
+#include "sweep.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+
+#include "opencv2/imgproc.hpp"
+#include "parallel.h"
+
+ParamRange ParamRange::parse(const std::string& text)
+{
+    try
+    {
+        size_t colon = text.find(':');
+        if (colon == std::string::npos)
+        {
+            double value = std::stod(text);
+            return ParamRange{ value, value, 1.0 };
+        }
+        size_t second = text.find(':', colon + 1);
+        if (second == std::string::npos)
+        {
+            throw std::invalid_argument(text);
+        }
+        return ParamRange{ std::stod(text.substr(0, colon)), std::stod(text.substr(colon + 1, second - colon - 1)),
+                           std::stod(text.substr(second + 1)) };
+    }
+    catch (const std::logic_error&)
+    {
+        throw std::invalid_argument("Ranges are written as value or first:last:step: " + text);
+    }
+}
+
+std::vector<double> ParamRange::values() const
+{
+    if (!(step > 0.0) || last < first)
+    {
+        throw std::invalid_argument("A range needs a positive step and first <= last");
+    }
+    // Indexed rather than accumulated, and with some slack so that last is included despite rounding
+    size_t count = static_cast<size_t>(floor((last - first) / step + 1e-9)) + 1;
+    std::vector<double> values(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        values[i] = first + double(i) * step;
+    }
+    return values;
+}
+
+ParameterSweep::ParameterSweep(const cv::Mat& inputImg, const cv::Mat& originalImg, const SweepRanges& ranges,
+                               bool fused, bool pad_band)
+  : original(originalImg),
+    motion_sweep(inputImg,
+                 fused ? PSFParams::combined(int(lround(ranges.len.last)), 0.0, int(lround(ranges.r.last)))
+                       : PSFParams::motion(int(lround(ranges.len.last)), 0.0),
+                 1, pad_band),
+    largest_circle(PSFParams::circle(int(lround(ranges.r.last)))),
+    fused(fused),
+    pad_band(pad_band)
+{
+    // The restored images have no alpha channel
+    if (original.channels() == 4)
+    {
+        cv::cvtColor(originalImg, original, cv::COLOR_BGRA2BGR);
+    }
+}
+
+double ParameterSweep::evaluate(const RestoreParams& params, SweepScratch& scratch) const
+{
+    if (fused)
+    {
+        motion_sweep.restore(PSFParams::combined(params.len, params.theta, params.r), params.snr1, scratch.restored,
+                             scratch.wiener);
+        return calcPSNR(original, scratch.restored);
+    }
+    if (!scratch.valid || scratch.len != params.len || scratch.theta != params.theta || scratch.snr1 != params.snr1)
+    {
+        scratch.valid = false;
+        motion_sweep.restore(PSFParams::motion(params.len, params.theta), params.snr1, scratch.demotion, scratch.wiener);
+        scratch.oof_sweep.emplace(scratch.demotion, largest_circle, 1, pad_band);
+        scratch.len = params.len;
+        scratch.theta = params.theta;
+        scratch.snr1 = params.snr1;
+        scratch.valid = true;
+    }
+    scratch.oof_sweep->restore(PSFParams::circle(params.r), params.snr2, scratch.restored, scratch.wiener);
+    return calcPSNR(original, scratch.restored);
+}
+
+SweepResult ParameterSweep::run(const SweepRanges& ranges, unsigned thread_count,
+                                const std::function<void(const SweepResult&)>& on_result) const
+{
+    const std::vector<double> lens = ranges.len.values();
+    const std::vector<double> thetas = ranges.theta.values();
+    const std::vector<double> snr1s = ranges.snr1.values();
+    const std::vector<double> rs = ranges.r.values();
+    const std::vector<double> snr2s = ranges.snr2.values();
+
+    // Every motion stage is followed by its r * snr2 candidates, which the scratch of a worker evaluates in a row
+    const size_t per_stage = rs.size() * snr2s.size();
+    const size_t total = lens.size() * thetas.size() * snr1s.size() * per_stage;
+    thread_count = resolveThreadCount(thread_count, total);
+    // Whole motion stages per chunk, unless that leaves too few chunks to keep the workers busy
+    const size_t chunk = std::max<size_t>(1, std::min(per_stage, total / (size_t(thread_count) * 4)));
+    const size_t chunk_count = (total + chunk - 1) / chunk;
+    thread_count = resolveThreadCount(thread_count, chunk_count);
+
+    // The defocus filters are shared by every chunk and must stay cached for the whole sweep
+    FilterCache::Reservation reservation(FilterCache::instance(),
+                                         rs.size() * (snr2s.size() + 1) + 4 * size_t(thread_count));
+
+    std::mutex mutex;
+    SweepResult best{ RestoreParams{ 0, 0.0, 0.0, 0, 0.0 }, -1.0 };
+    size_t best_index = total;
+    std::vector<SweepScratch> scratches(thread_count);
+    parallelFor(chunk_count, thread_count, [&](size_t c, unsigned worker) {
+        for (size_t i = c * chunk; i < std::min(total, (c + 1) * chunk); i++)
+        {
+            size_t stage = i / per_stage;
+            size_t snr1_index = stage % snr1s.size();
+            size_t theta_index = (stage / snr1s.size()) % thetas.size();
+            size_t len_index = stage / (snr1s.size() * thetas.size());
+            RestoreParams params{ int(lround(lens[len_index])), thetas[theta_index], snr1s[snr1_index],
+                                  int(lround(rs[(i % per_stage) / snr2s.size()])), snr2s[i % snr2s.size()] };
+            SweepResult result{ params, evaluate(params, scratches[worker]) };
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (on_result)
+            {
+                on_result(result);
+            }
+            if (result.psnr > best.psnr || (result.psnr == best.psnr && i < best_index))
+            {
+                best = result;
+                best_index = i;
+            }
+        }
+    });
+    return best;
+}
+
+SweepLog::SweepLog(const std::filesystem::path& csv_filename, const std::filesystem::path& json_filename)
+{
+    if (!csv_filename.empty())
+    {
+        csv.open(csv_filename);
+        if (!csv)
+        {
+            throw std::filesystem::filesystem_error("Unable to open file", csv_filename, std::make_error_code(std::io_errc::stream));
+        }
+        csv << std::fixed << std::setprecision(6);
+        csv << "len,theta,snr1,r,snr2,psnr\n";
+    }
+    if (!json_filename.empty())
+    {
+        json.open(json_filename);
+        if (!json)
+        {
+            throw std::filesystem::filesystem_error("Unable to open file", json_filename, std::make_error_code(std::io_errc::stream));
+        }
+        json << std::fixed << std::setprecision(6);
+        json << "[";
+    }
+}
+
+SweepLog::~SweepLog()
+{
+    if (json.is_open())
+    {
+        json << "\n]\n";
+    }
+}
+
+void SweepLog::write(const SweepResult& result)
+{
+    const RestoreParams& p = result.params;
+    if (csv.is_open())
+    {
+        csv << p.len << ',' << p.theta << ',' << p.snr1 << ',' << p.r << ',' << p.snr2 << ',' << result.psnr << '\n';
+    }
+    if (json.is_open())
+    {
+        json << (first ? "\n" : ",\n") << "  { \"len\": " << p.len << ", \"theta\": " << p.theta << ", \"snr1\": " << p.snr1
+             << ", \"r\": " << p.r << ", \"snr2\": " << p.snr2 << ", \"psnr\": " << result.psnr << " }";
+        first = false;
+    }
+}
@@ -0,0 +1,131 @@
+/**
+ * @file sweep.h
+ * @brief The parameter sweep of the two-stage restoration: motion deblurring (len, theta, snr1) followed by
+ * defocus deblurring (r, snr2), scored by the PSNR against the original image.
+ * @version 0.1
+ * @date 2023-12-18
+ *
+ */
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <stddef.h>
+
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "opencv2/core/mat.hpp"
+#include "restore_cv.h"
+
+/**
+ * @brief The values first, first + step, ... up to last, inclusive.
+ */
+struct ParamRange
+{
+    double first;
+    double last;
+    double step;
+
+    // Parses "value" or "first:last:step"
+    static ParamRange parse(const std::string& text);
+    std::vector<double> values() const;
+};
+
+struct SweepRanges
+{
+    ParamRange len;
+    ParamRange theta;
+    ParamRange snr1;
+    ParamRange r;
+    ParamRange snr2;
+};
+
+struct RestoreParams
+{
+    int len;
+    double theta;
+    double snr1;
+    int r;
+    double snr2;
+};
+
+struct SweepResult
+{
+    RestoreParams params;
+    double psnr;
+};
+
+/**
+ * @brief The state one thread keeps between evaluations: its last motion deblurred image with its spectra, so that
+ * candidates differing in r and snr2 only run the defocus stage, and the Wiener buffers.
+ */
+struct SweepScratch
+{
+    bool valid = false;
+    int len = 0;
+    double theta = 0.0;
+    double snr1 = 0.0;
+    cv::Mat demotion;
+    std::optional<WienerSweep> oof_sweep;
+    WienerScratch wiener;
+    cv::Mat restored;
+};
+
+/**
+ * @brief Evaluates every combination of the parameter ranges on the worker pool of parallel.h.
+ * The candidates are ordered with snr2 innermost and handed out in chunks, and each worker keeps its last motion
+ * deblurred image and its spectra in its own scratch, so a chunk runs the motion stage once. The first restoration
+ * stage reuses the spectra of the input image for every len, theta and snr1.
+ */
+class ParameterSweep
+{
+  public:
+    // A fused sweep restores in one pass with the combined PSF and snr1 as its snr; snr2 is then ignored. With
+    // pad_band, the transforms are padded for the largest PSF of ranges, so run should stay within them
+    ParameterSweep(const cv::Mat& inputImg, const cv::Mat& originalImg, const SweepRanges& ranges, bool fused = false,
+                   bool pad_band = false);
+
+    // Restores the image with one set of parameters and returns its PSNR
+    double evaluate(const RestoreParams& params, SweepScratch& scratch) const;
+
+    /**
+     * @brief Runs the sweep and returns the candidate with the highest PSNR (the first one on a tie).
+     *
+     * @param ranges The values of each parameter.
+     * @param thread_count The number of worker threads, or 0 for one per hardware thread.
+     * @param on_result Called for every candidate as it completes, by one thread at a time.
+     */
+    SweepResult run(const SweepRanges& ranges, unsigned thread_count = 0,
+                    const std::function<void(const SweepResult&)>& on_result = {}) const;
+
+  private:
+    cv::Mat original;
+    WienerSweep motion_sweep;
+    PSFParams largest_circle;
+    bool fused;
+    bool pad_band;
+};
+
+/**
+ * @brief Streams sweep results to a CSV and/or a JSON file; an empty file name skips that format.
+ */
+class SweepLog
+{
+  public:
+    SweepLog(const std::filesystem::path& csv_filename, const std::filesystem::path& json_filename);
+    ~SweepLog();
+
+    void write(const SweepResult& result);
+
+  private:
+    std::ofstream csv;
+    std::ofstream json;
+    bool first = true;
+};
+
+#endif  // SWEEP_H